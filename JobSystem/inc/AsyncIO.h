@@ -0,0 +1,100 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include "Job.h"
+
+namespace Insight::JS
+{
+	class JobSystem;
+
+	/// <summary>
+	/// Bytes read by an asynchronous file job.
+	/// </summary>
+	struct Buffer
+	{
+		std::vector<uint8_t> Data;
+		int32_t Error = 0;		// errno value of the failed open/read, 0 on success.
+
+		bool IsValid() const { return Error == 0; }
+	};
+
+	/// <summary>
+	/// Asynchronous file reads backed by io_uring.
+	/// Reads are submitted from any thread and a single reaper thread waits on the completion queue.
+	/// When a read completes its job is scheduled on the job system which requested it, so the job
+	/// and its 'Then' children run on compute workers. No thread blocks in 'read()'.
+	/// Without io_uring (non Linux, or the kernel refuses it) reads are done on the blocking thread pool.
+	/// </summary>
+	class AsyncIO : public NonCopyable
+	{
+	public:
+		AsyncIO() = default;
+		~AsyncIO();
+
+		bool Init(uint32_t queueDepth);
+		void Release();
+
+		// 'size' of 0 reads until the end of the file.
+		JobWithResultSharedPtr<Buffer> ReadFile(JobSystem& jobSystem, std::string const& path, uint64_t offset, uint64_t size, JobPriority priority);
+
+		// False once the ring has failed, reads then use the blocking thread pool.
+		bool IsAsync() const { return m_ringFd >= 0 && !m_failed.load(std::memory_order_acquire); }
+
+	private:
+		struct ReadRequest
+		{
+			int Fd = -1;
+			uint64_t Offset = 0;
+			uint64_t BytesRead = 0;
+			bool EndOfFile = false;
+			Buffer Result;
+			JobSharedPtr Job;
+			JobSystem* System = nullptr;
+		};
+
+		bool SetupRing(uint32_t queueDepth);
+		void Submit(ReadRequest* request);
+		bool PushSubmission(ReadRequest* request, uint8_t opcode);
+		void Complete(ReadRequest* request);
+		void ReaperLoop();
+		// The ring can't be used any more, complete every read in flight or waiting with 'error'.
+		void FailRequests(int error);
+
+	private:
+		int m_ringFd = -1;
+
+		// Submission queue ring.
+		void* m_sqRing = nullptr;
+		size_t m_sqRingSize = 0;
+		uint32_t* m_sqHead = nullptr;
+		uint32_t* m_sqTail = nullptr;
+		uint32_t* m_sqMask = nullptr;
+		uint32_t* m_sqArray = nullptr;
+		void* m_sqes = nullptr;
+		size_t m_sqesSize = 0;
+		uint32_t m_sqEntries = 0;
+
+		// Completion queue ring.
+		void* m_cqRing = nullptr;
+		size_t m_cqRingSize = 0;
+		uint32_t* m_cqHead = nullptr;
+		uint32_t* m_cqTail = nullptr;
+		uint32_t* m_cqMask = nullptr;
+		void* m_cqes = nullptr;
+		uint32_t m_cqEntries = 0;
+
+		std::mutex m_submitMutex;
+		std::vector<ReadRequest*> m_inFlightRequests;	// Submitted to the ring, at most the completion queue size.
+		std::deque<ReadRequest*> m_pendingRequests;		// Waiting for a free completion slot.
+		std::atomic_bool m_failed = false;				// Set with 'm_submitMutex' held.
+
+		std::atomic_bool m_stopping = false;
+		std::thread m_reaperThread;
+	};
+}
\ No newline at end of file
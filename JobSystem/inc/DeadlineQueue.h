@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Job.h"
+
+namespace Insight::JS
+{
+	/// <summary>
+	/// Jobs with a deadline, dequeued earliest deadline first (EDF).
+	/// Jobs are spread over several min-heaps (shards) so concurrent workers rarely take the same lock.
+	/// Each shard publishes its earliest deadline, a worker picks the shard with the earliest one and
+	/// moves on to the next best shard if that lock is taken. The order is exact EDF while workers don't
+	/// race for the same shard, and otherwise at worst another shard's head runs first.
+	/// </summary>
+	class DeadlineQueue
+	{
+	public:
+		// 'numShards' is clamped to [1, 64].
+		explicit DeadlineQueue(uint32_t numShards);
+		DeadlineQueue(DeadlineQueue const& other) = delete;
+
+		// 'shardHint' keeps a worker enqueueing on its own shard, any value is valid.
+		void Enqueue(JobSharedPtr const& job, uint32_t shardHint);
+		bool Dequeue(JobSharedPtr& job);
+
+		uint32_t size() const { return m_size.load(std::memory_order_acquire); }
+		// steady_clock nanoseconds of the earliest deadline queued, UINT64_MAX when empty.
+		uint64_t GetEarliestDeadline() const;
+
+		DeadlineQueue& operator=(DeadlineQueue const& other) = delete;
+
+	private:
+		struct alignas(64) Shard
+		{
+			std::mutex Mutex;
+			std::vector<JobSharedPtr> Heap;
+			std::atomic<uint64_t> EarliestDeadline = UINT64_MAX;
+		};
+
+		std::unique_ptr<Shard[]> m_shards;
+		uint32_t m_numShards = 0;
+		std::atomic<uint32_t> m_size = 0;
+	};
+}
@@ -5,6 +5,11 @@
 #include <memory>
 #include <mutex>
 #include <condition_variable>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <variant>
 #include "Thread.h"
 #include "JobFuncWrapper.h"
 #include "LockFreeQueue.h"
@@ -16,6 +21,7 @@ namespace Insight::JS
 	class JobQueue;
 	class JobSystem;
 	class IJob;
+	struct JobRecurrence;
 	template<typename ResultType>
 	class JobWithResult;
 
@@ -39,6 +45,15 @@ namespace Insight::JS
 		Low
 	};
 
+	/// <summary>
+	/// What a 'Then' child does when the job it follows threw an exception.
+	/// </summary>
+	enum class JobExceptionPolicy : uint8_t
+	{
+		RunAnyway,					// Run as normal, the parent's exception is only seen by waiting on the parent.
+		CancelOnParentException,	// Don't run, the child (and its own children) are canceled and rethrow the parent's exception.
+	};
+
 	enum class JobState
 	{
 		Queued,
@@ -76,22 +91,55 @@ namespace Insight::JS
 		bool IsCancled() const { return m_state.load() == JobState::Canceled; }
 		JobState GetState() { return m_state.load(); }
 
+		// Name shown in traces. Must outlive the job, a string literal is expected.
+		const char* GetName() const { return m_name; }
+		void SetName(const char* name) { m_name = name; }
+		// steady_clock nanoseconds the job must finish by, 0 when it has no deadline.
+		uint64_t GetDeadline() const { return m_deadline; }
+		// Recurring jobs (see JobSystem::ScheduleJobEvery): runs finished so far and periods with no run of their own.
+		bool IsRecurring() const { return m_recurrence != nullptr; }
+		uint64_t GetRecurringRuns() const;
+		uint64_t GetMissedPeriods() const;
+
+		// Exception thrown by the job's function (or by the job it followed, see JobExceptionPolicy), nullptr if none.
+		std::exception_ptr GetException() const { return m_exception; }
+		bool HasException() const { return m_exception != nullptr; }
+		// Policy of children added by 'Then' from now on.
+		void SetExceptionPolicy(JobExceptionPolicy policy) { m_exceptionPolicy = policy; }
+		JobExceptionPolicy GetExceptionPolicy() const { return m_exceptionPolicy; }
+
+		// Wait for the job to finish, rethrows the job's exception. On a worker thread other jobs are run meanwhile.
 		void Wait();
 
 		template<typename Func, typename... Args>
 		auto Then(Func func, Args... args)
+		{
+			return Then(m_exceptionPolicy, std::move(func), std::move(args)...);
+		}
+
+		// Add a child with its own exception policy, the child passes it on to its children.
+		template<typename Func, typename... Args>
+		auto Then(JobExceptionPolicy policy, Func func, Args... args)
 		{
 			using ResultType = std::invoke_result_t<Func, Args...>;
 			std::unique_ptr<JobResult<ResultType>> jobResult = std::make_unique<JobResult<ResultType>>();
 			std::unique_ptr<IJobFuncWrapper> funcWrapper = std::make_unique<JobFuncWrapper<ResultType, Func, Args...>>(jobResult.get(), func, std::move(args)...);
 			JobWithResultSharedPtr<ResultType> job = std::make_shared<JobWithResult<ResultType>>(m_priority, std::move(funcWrapper), this, std::move(jobResult));
-			m_childrenJobs.push_back(job);
+			job->m_exceptionPolicy = policy;
+			AddChild(job);
 			return job;
 		}
 
 	private:
 		virtual void Call();
 		void ReleaseLock();
+		// Make 'job' a child of this job, it is scheduled once its last parent needed has finished.
+		void AddChild(JobSharedPtr const& job);
+		// Called as each parent of this job finishes, returns true when the job should be scheduled.
+		// 'noValue' is true for a parent canceled without a result or exception.
+		bool OnParentFinished(bool noValue);
+		void ScheduleChild(JobSharedPtr const& job);
+		void SetException(std::exception_ptr exception);
 
 		void SetState(JobState state) { m_state.store(state); }
 
@@ -99,18 +147,30 @@ namespace Insight::JS
 		std::atomic<JobState> m_state;
 		uint16_t m_currentChildJob = 0;
 		std::vector<JobSharedPtr> m_childrenJobs;
+		std::mutex m_childrenMutex;		// Guards 'm_childrenJobs' against 'Then' racing with the job finishing.
 		JobPtr m_parentJob = nullptr;
+		JobSystem* m_jobSystem = nullptr;	// Job system 'Then' children are scheduled on once this job has finished.
 		JobPriority m_priority;
+		const char* m_name = nullptr;
+		uint64_t m_scheduledTicks = 0;		// TraceClock tick the job was last put in a queue.
+		JobPriority m_scheduledPriority = JobPriority::Normal;	// Queue the job was last put in.
+		uint64_t m_deadline = 0;
+		std::exception_ptr m_exception;
+		JobExceptionPolicy m_exceptionPolicy = JobExceptionPolicy::RunAnyway;
 		//std::mutex m_mutex;
 		std::condition_variable m_conditionVariable;
 		std::atomic_bool m_locked;
 		std::unique_ptr<IJobFuncWrapper> m_funcWrapper;
+		std::unique_ptr<JobRecurrence> m_recurrence;	// Set while the job runs every period.
+		std::atomic<uint32_t> m_pendingParents = 1;		// Parents left to finish before the job is scheduled as a child (N for WhenAll).
+		std::atomic<uint32_t> m_unfinishedParents = 0;	// WhenAny: parents not finished yet, a canceled one only counts if it is the last.
 
 	private:
 		friend class JobWaitList;
 		friend JobQueue;
 		friend JobSystem;
 		friend class JobSystemManager;
+		friend struct JobCombinators;
 	};
 
 	/// <summary>
@@ -128,22 +188,167 @@ namespace Insight::JS
 		JobWithResult(JobPriority priority, std::unique_ptr<IJobFuncWrapper> funcWrapper, std::unique_ptr<JobResult<ResultType>> jobResult)
 			: IJob(priority, std::move(funcWrapper))
 			, m_result(std::move(jobResult))
-		{ }
+		{
+			m_result->m_job = this;
+		}
 		JobWithResult(JobPriority priority, std::unique_ptr<IJobFuncWrapper> funcWrapper, JobPtr parentJob, std::unique_ptr<JobResult<ResultType>> jobResult)
 			: IJob(priority, std::move(funcWrapper), parentJob)
 			, m_result(std::move(jobResult))
-		{ }
+		{
+			m_result->m_job = this;
+		}
 
 		virtual ~JobWithResult() override
 		{
+			if (m_result)
+			{
+				m_result->m_job = nullptr;
+			}
 			m_result.reset();
 		}
 
 		bool IsValid() const { return m_result != nullptr; }
 		bool IsReady() const { return m_result->IsReady(); }
 		JobResult<ResultType>& GetResult() { return *m_result; }
+		// The result outlives the job while this is held, continuations hold it instead of the job.
+		std::shared_ptr<JobResult<ResultType>> const& GetSharedResult() const { return m_result; }
+		// The shared result for a consumer which moves the result out ('Then', WhenAll, WhenAny). Only one
+		// consumer can, a second claim throws. Void results are never moved so they can be claimed any number of times.
+		std::shared_ptr<JobResult<ResultType>> const& ClaimResult()
+		{
+			if constexpr (!std::is_void_v<ResultType>)
+			{
+				if (m_resultClaimed.exchange(true, std::memory_order_acq_rel))
+				{
+					throw std::logic_error("[JobWithResult::ClaimResult] The result is already taken by another child.");
+				}
+			}
+			return m_result;
+		}
+
+		/// <summary>
+		/// Add a child which runs once this job has finished. If 'func' takes this job's result followed by 'args'
+		/// the result is moved into it, otherwise it is called with 'args' only. Only one child per job can take
+		/// the result (see 'ClaimResult'), adding a second throws. The child rethrows this job's exception when it takes the result.
+		/// </summary>
+		template<typename Func, typename... Args>
+		auto Then(Func func, Args... args)
+		{
+			return Then(m_exceptionPolicy, std::move(func), std::move(args)...);
+		}
+
+		template<typename Func, typename... Args>
+		auto Then(JobExceptionPolicy policy, Func func, Args... args)
+		{
+			if constexpr (std::is_void_v<ResultType> || !std::is_invocable_v<Func, ResultType, Args...>)
+			{
+				return IJob::Then(policy, std::move(func), std::move(args)...);
+			}
+			else
+			{
+				// Hold the result rather than this job, this job holds its children.
+				std::shared_ptr<JobResult<ResultType>> result = ClaimResult();
+				return IJob::Then(policy, [result, func](Args... args) mutable
+								  {
+									  return func(result->TakeResult(), std::move(args)...);
+								  }, std::move(args)...);
+			}
+		}
 
 	private:
-		std::unique_ptr<JobResult<ResultType>> m_result = nullptr;
+		std::shared_ptr<JobResult<ResultType>> m_result = nullptr;
+		std::atomic<bool> m_resultClaimed = false;
+	};
+
+	// Value of a job's result in WhenAll and WhenAny, void results are std::monostate.
+	template<typename ResultType>
+	using JobResultValue = std::conditional_t<std::is_void_v<ResultType>, std::monostate, ResultType>;
+
+	/// <summary>
+	/// Builds the jobs of WhenAll and WhenAny.
+	/// </summary>
+	struct JobCombinators
+	{
+		template<typename ResultType>
+		static JobResultValue<ResultType> TakeValue(JobResult<ResultType>& result)
+		{
+			if constexpr (std::is_void_v<ResultType>)
+			{
+				result.GetResult();
+				return { };
+			}
+			else
+			{
+				return result.TakeResult();
+			}
+		}
+
+		template<typename VariantType, typename Results, size_t... Indices>
+		static VariantType TakeFirstReady(Results& results, std::index_sequence<Indices...>)
+		{
+			std::optional<VariantType> value;
+			((!value && std::get<Indices>(results)->IsReady() ? (value.emplace(std::in_place_index<Indices>, TakeValue(*std::get<Indices>(results))), 0) : 0), ...);
+			if (!value)
+			{
+				// Only scheduled with nothing ready once the last job has been canceled.
+				throw std::runtime_error("[WhenAny] Every job was canceled.");
+			}
+			return std::move(*value);
+		}
+
+		// Create a job which is scheduled once 'parentsNeeded' of 'parents' have finished.
+		template<typename ResultType, typename Func>
+		static JobWithResultSharedPtr<ResultType> CreateChildOf(std::initializer_list<IJob*> parents, uint32_t parentsNeeded, Func func)
+		{
+			std::unique_ptr<JobResult<ResultType>> jobResult = std::make_unique<JobResult<ResultType>>();
+			std::unique_ptr<IJobFuncWrapper> funcWrapper = std::make_unique<JobFuncWrapper<ResultType, Func>>(jobResult.get(), func);
+			JobWithResultSharedPtr<ResultType> job = std::make_shared<JobWithResult<ResultType>>((*parents.begin())->m_priority, std::move(funcWrapper), std::move(jobResult));
+			job->m_pendingParents.store(parentsNeeded, std::memory_order_relaxed);
+			if (parentsNeeded < parents.size())
+			{
+				job->m_unfinishedParents.store(static_cast<uint32_t>(parents.size()), std::memory_order_relaxed);
+			}
+			for (IJob* parent : parents)
+			{
+				parent->AddChild(job);
+			}
+			return job;
+		}
 	};
+
+	/// <summary>
+	/// Job which runs once every job has finished, its result is a tuple of their results (moved out of the jobs,
+	/// so none of them can have another child taking its result). It rethrows the exception of the first job in the list which threw.
+	/// </summary>
+	template<typename... ResultTypes>
+	JobWithResultSharedPtr<std::tuple<JobResultValue<ResultTypes>...>> WhenAll(JobWithResultSharedPtr<ResultTypes> const&... jobs)
+	{
+		static_assert(sizeof...(ResultTypes) > 0, "[WhenAll] At least one job is needed.");
+		using CombinedType = std::tuple<JobResultValue<ResultTypes>...>;
+		std::tuple<std::shared_ptr<JobResult<ResultTypes>>...> results(jobs->ClaimResult()...);
+		return JobCombinators::CreateChildOf<CombinedType>({ jobs.get()... }, static_cast<uint32_t>(sizeof...(ResultTypes)), [results]() mutable
+														   {
+															   return std::apply([](auto&... result)
+																				 {
+																					 return CombinedType{ JobCombinators::TakeValue(*result)... };
+																				 }, results);
+														   });
+	}
+
+	/// <summary>
+	/// Job which runs once the first of the jobs has finished, its result is a variant holding that job's result
+	/// at the job's index (moved out of the job, so none of them can have another child taking its result).
+	/// It rethrows that job's exception. Canceled jobs are skipped, it throws if every job is canceled.
+	/// </summary>
+	template<typename... ResultTypes>
+	JobWithResultSharedPtr<std::variant<JobResultValue<ResultTypes>...>> WhenAny(JobWithResultSharedPtr<ResultTypes> const&... jobs)
+	{
+		static_assert(sizeof...(ResultTypes) > 0, "[WhenAny] At least one job is needed.");
+		using CombinedType = std::variant<JobResultValue<ResultTypes>...>;
+		std::tuple<std::shared_ptr<JobResult<ResultTypes>>...> results(jobs->ClaimResult()...);
+		return JobCombinators::CreateChildOf<CombinedType>({ jobs.get()... }, 1, [results]() mutable
+														   {
+															   return JobCombinators::TakeFirstReady<CombinedType>(results, std::index_sequence_for<ResultTypes...>());
+														   });
+	}
 }
\ No newline at end of file
@@ -8,6 +8,8 @@ namespace Insight::JS
 	{
 		virtual ~IJobFuncWrapper() = default;
 		virtual void Call() = 0;
+		// Store the exception 'Call' threw in the job's result, nullptr clears it.
+		virtual void SetException(std::exception_ptr exception) = 0;
 	};
 
 	template <typename ResultType, typename Func, typename... Args>
@@ -27,6 +29,7 @@ namespace Insight::JS
 			if constexpr (std::is_void_v<ResultType>)
 			{
 				std::apply(m_func, m_args);
+				m_jobResult->SetResult();
 			}
 			else
 			{
@@ -34,6 +37,11 @@ namespace Insight::JS
 			}
 		}
 
+		virtual void SetException(std::exception_ptr exception) override
+		{
+			m_jobResult->SetException(std::move(exception));
+		}
+
 	private:
 		JobResult<ResultType>* m_jobResult;
 		Func m_func;
@@ -1,40 +1,124 @@
 #pragma once
 
 #include <assert.h>
+#include <atomic>
+#include <exception>
+#include <optional>
 
 namespace Insight::JS
 {
+	class IJob;
+	template<typename ResultType>
+	class JobWithResult;
+
+	/// <summary>
+	/// Readiness and exception of a JobResult. The worker publishes the result with a release store of
+	/// 'm_isReady', so a reader which sees 'IsReady' also sees the result.
+	/// </summary>
+	struct JobResultBase
+	{
+		bool IsReady() const { return m_isReady.load(std::memory_order_acquire); }
+
+		// Exception thrown by the job, 'GetResult' rethrows it. nullptr clears it.
+		void SetException(std::exception_ptr exception)
+		{
+			m_exception = std::move(exception);
+			if (m_exception)
+			{
+				SetReady();
+			}
+		}
+		std::exception_ptr GetException() const { return m_exception; }
+		bool HasException() const { return m_exception != nullptr; }
+
+	protected:
+		void SetReady() { m_isReady.store(true, std::memory_order_release); }
+		// Block until the result is ready. On a worker thread other jobs are run meanwhile.
+		// Throws if the job was canceled before setting a result.
+		void WaitForResult() const;
+		void RethrowIfFailed() const
+		{
+			if (m_exception)
+			{
+				std::rethrow_exception(m_exception);
+			}
+		}
+
+	private:
+		IJob* m_job = nullptr;		// Job which sets the result.
+		std::atomic_bool m_isReady = false;
+		std::exception_ptr m_exception;
+
+		template<typename ResultType>
+		friend class JobWithResult;
+	};
+
 	template<typename ResultType, bool>
-	struct IJobResult
+	struct IJobResult : public JobResultBase
 	{
 		IJobResult()
 		{ }
 
-		bool IsReady() const { return true; }
-		ResultType GetResult() const { /*assert(false && "[JobResult<void>::GetResult] Can not get the result of a void JobResult.");*/ }
+		void SetResult() { SetReady(); }
+		// Wait for the job, rethrowing its exception.
+		ResultType GetResult() const
+		{
+			WaitForResult();
+			RethrowIfFailed();
+		}
 	};
 
+	/// <summary>
+	/// Result of a job. A recurring job overwrites it every run, read it between runs (from a 'Then' child
+	/// or after cancelling) as a read during a run races with the write.
+	/// </summary>
 	template<typename ResultType>
-	struct IJobResult<ResultType, false>
+	struct IJobResult<ResultType, false> : public JobResultBase
 	{
 		IJobResult()
-			: m_isReady(false)
 		{ }
 		
 		void SetResult(ResultType resultType)
 		{
-			m_result = resultType;
-			m_isReady = true;
+			m_result.emplace(std::move(resultType));
+			SetReady();
 		}
 		
-		bool IsReady() const { return m_isReady; }
-		ResultType GetResult() const { return m_result; }
+		// Wait for the result and copy it, rethrowing the job's exception.
+		ResultType GetResult() const
+		{
+			WaitForResult();
+			RethrowIfFailed();
+			assert(m_result && "[JobResult::GetResult] The result has been taken.");
+			return *m_result;
+		}
+		// Copy the result into 'result' if it is ready, rethrowing the job's exception. Never waits.
+		bool TryGetResult(ResultType& result) const
+		{
+			if (!IsReady())
+			{
+				return false;
+			}
+			RethrowIfFailed();
+			assert(m_result && "[JobResult::TryGetResult] The result has been taken.");
+			result = *m_result;
+			return true;
+		}
+		// Wait for the result and move it out, the result can't be read again.
+		ResultType TakeResult()
+		{
+			WaitForResult();
+			RethrowIfFailed();
+			assert(m_result && "[JobResult::TakeResult] The result has been taken.");
+			ResultType result = std::move(*m_result);
+			m_result.reset();
+			return result;
+		}
 
 	private:
-		ResultType m_result;
-		bool m_isReady;
+		std::optional<ResultType> m_result;
 	};
 
 	template<typename ResultType>
 	class JobResult : public IJobResult<ResultType, std::is_void_v<ResultType>> { };
-}
\ No newline at end of file
+}
@@ -2,8 +2,12 @@
 
 #include <stdint.h>
 #include <thread>
+#include <chrono>
 #include <array>
 #include "Job.h"
+#include "AsyncIO.h"
+#include "DeadlineQueue.h"
+#include "TimingWheel.h"
 
 namespace Insight::JS
 {
@@ -19,6 +23,101 @@ namespace Insight::JS
 		size_t HighPriorityQueueSize = 512;		// High Priority
 		size_t NormalPriorityQueueSize = 2048;	// Normal Priority
 		size_t LowPriorityQueueSize = 4096;		// Low Priority
+		uint32_t DeadlineQueueShards = 16;		// Heaps jobs with a deadline are spread over, max 64.
+	};
+
+	/// <summary>
+	/// How a worker picks the priority queue to take its next job from.
+	/// </summary>
+	enum class JobSchedulingPolicy : uint8_t
+	{
+		Strict,			// Always High, then Normal, then Low. Low can starve while High/Normal jobs keep coming.
+		WeightedFair,	// Out of every High + Normal + Low weight dequeues, each queue is tried first 'weight' times.
+		Aging,			// A non empty queue which has not been dequeued from for its aging time is tried first.
+	};
+
+	/// <summary>
+	/// Starvation protection of a job system's queues. Every policy falls back to the next non empty
+	/// queue in strict order, so no worker idles while any queue has jobs.
+	/// </summary>
+	struct JobSchedulingOptions
+	{
+		JobSchedulingPolicy Policy = JobSchedulingPolicy::Strict;
+
+		// WeightedFair: while Low has jobs it gets at least LowWeight / (sum of weights) of the dequeues.
+		uint32_t HighWeight = 8;
+		uint32_t NormalWeight = 4;
+		uint32_t LowWeight = 1;
+
+		// Aging: while a queue has jobs, at least one of them starts every aging interval, and every job
+		// which has waited longer than its aging interval starts before the queues above it.
+		uint32_t NormalAgingMs = 8;
+		uint32_t LowAgingMs = 16;
+	};
+
+	/// <summary>
+	/// What a recurring job's next run is timed from, see 'JobSystem::ScheduleJobEvery'.
+	/// </summary>
+	enum class JobRecurrenceMode : uint8_t
+	{
+		FixedRate,		// Runs are whole periods apart from the first one, a slow run doesn't push later runs back.
+		FixedDelay,		// Each run is one period after the previous run finished.
+	};
+
+	/// <summary>
+	/// What a fixed rate job does with periods which passed while it was late (a long run or busy workers).
+	/// </summary>
+	enum class JobMissedPeriods : uint8_t
+	{
+		Skip,			// Drop them, the next run is at the next period still ahead.
+		Coalesce,		// Run once straight away in place of all of them, then carry on at the next period.
+	};
+
+	struct JobRecurrenceOptions
+	{
+		JobRecurrenceMode Mode = JobRecurrenceMode::FixedRate;
+		JobMissedPeriods MissedPeriods = JobMissedPeriods::Skip;
+	};
+
+	/// <summary>
+	/// State of a recurring job, owned by the job.
+	/// </summary>
+	struct JobRecurrence
+	{
+		JobRecurrenceOptions Options;
+		uint64_t PeriodNs = 0;
+		uint64_t NextRunNs = 0;						// steady_clock time the pending run is due at.
+		TimerHandle Timer;
+		bool Stopped = false;
+		std::mutex Mutex;							// Guards 'Timer' and 'Stopped' between rescheduling and cancelling.
+		std::atomic<uint64_t> Runs = 0;
+		std::atomic<uint64_t> MissedPeriods = 0;
+	};
+
+	/// <summary>
+	/// Where a job may run, for jobs using thread-affine resources or data hot in one core's cache.
+	/// Affine jobs wait in a mailbox of their worker, which it checks before its job system's queues,
+	/// or of the main thread, which 'JobSystemManager::Update' runs. Workers are named by thread index (0 to NumThreads - 1, at most 64).
+	/// </summary>
+	struct JobAffinity
+	{
+		static JobAffinity Worker(uint32_t workerIndex) { return JobAffinity{ workerIndex < 64 ? 1ull << workerIndex : 0, false }; }
+		// Any worker in the mask (bit i is thread index i), the job goes to the one with the fewest affine jobs waiting.
+		static JobAffinity Workers(uint64_t workerMask) { return JobAffinity{ workerMask, false }; }
+		static JobAffinity MainThread() { return JobAffinity{ 0, true }; }
+
+		uint64_t WorkerMask = 0;
+		bool MainThreadOnly = false;
+	};
+
+	/// <summary>
+	/// How much main thread work one 'JobSystemManager::Update' may do. A job is never interrupted,
+	/// so one long job can overrun 'MaxTime'. Jobs posted while Update runs wait for the next one.
+	/// </summary>
+	struct MainThreadBudget
+	{
+		uint32_t MaxJobs = UINT32_MAX;
+		std::chrono::microseconds MaxTime = std::chrono::microseconds::max();
 	};
 
 	class JobQueue
@@ -26,18 +125,33 @@ namespace Insight::JS
 	public:
 		JobQueue(JobQueueOptions options = JobQueueOptions());
 
+		void SetSchedulingOptions(JobSchedulingOptions const& options);
+		JobSchedulingOptions const& GetSchedulingOptions() const { return m_schedulingOptions; }
+
 		void Update(uint32_t const& jobsToFree);
 
-		uint32_t GetPendingJobsCount() const { return m_highPriorityQueue.size() + m_normalPriorityQueue.size() + m_lowPriorityQueue.size(); }
-		uint32_t GetRunningJobsCount() const { return m_jobRunningQueue.size(); }
+		uint32_t GetPendingJobsCount() const { return m_highPriorityQueue.size() + m_normalPriorityQueue.size() + m_lowPriorityQueue.size() + m_deadlineQueue.size() + m_mailboxJobs.load(std::memory_order_acquire); }
+		uint32_t GetRunningJobsCount() const { return m_runningJobs.load(std::memory_order_relaxed); }
+		uint64_t GetQueueFullEvents() const { return m_queueFullEvents.load(std::memory_order_relaxed); }
 
 		// Jobs
 		void ScheduleJob(const JobSharedPtr job);
 		void ScheduleJob(JobPriority priority, const JobSharedPtr& job, bool GetParentJob);
+		void ScheduleJobWithDeadline(const JobSharedPtr& job, uint64_t deadline);
 
 	private:
 		LockFreeQueue<JobSharedPtr>* GetQueueByPriority(JobPriority priority);
 		bool GetNextJob(JobSharedPtr& job);
+		// With 'takeContinuation' 'job' is set to the job's first child, to be run next by the caller instead of queued.
+		void FinishJob(JobSharedPtr& job, bool takeContinuation = false);
+		// Schedule the job's children and release its waiters. The first child is handed to 'continuation' if given.
+		void CompleteJob(JobSharedPtr const& job, JobState state = JobState::Finished, JobSharedPtr* continuation = nullptr);
+		// Queue to try before the strict High, Normal, Low order.
+		LockFreeQueue<JobSharedPtr>* SelectQueue();
+		// True if a deadline job or a job of higher priority than 'priority' is queued.
+		bool HasMoreUrgentJobs(JobPriority priority) const;
+		// Aging: time 'job' has waited in its queue.
+		uint64_t GetWaitNanoseconds(IJob const& job, uint64_t nowNs) const;
 
 		void Release();
 
@@ -45,10 +159,33 @@ namespace Insight::JS
 		LockFreeQueue<JobSharedPtr> m_highPriorityQueue;
 		LockFreeQueue<JobSharedPtr> m_normalPriorityQueue;
 		LockFreeQueue<JobSharedPtr> m_lowPriorityQueue;
-		LockFreeQueue<JobSharedPtr> m_jobRunningQueue;
+		DeadlineQueue m_deadlineQueue;
+
+		JobSchedulingOptions m_schedulingOptions;
+		std::vector<JobPriority> m_weightedOrder;			// WeightedFair: first choice of each dequeue in a round.
+		std::atomic<uint64_t> m_dequeueTicket = 0;
+		std::array<std::atomic<uint64_t>, 3> m_agingSinceNs = { };	// Aging: no job of the queue has waited since before this steady_clock time.
+		TraceClockCalibration m_clockStart;				// Aging: converts the TraceClock ticks jobs are queued at to time.
+		std::atomic<uint32_t> m_runningJobs = 0;		// Jobs taken by GetNextJob which have not been through FinishJob.
+		std::atomic<uint32_t> m_mailboxJobs = 0;		// Affine jobs of this queue waiting in a worker or main thread mailbox.
+		std::atomic<uint64_t> m_queueFullEvents = 0;
 
 		friend JobSystem;
 		friend JobSystemManager;
+		friend IJob;
+	};
+
+	/// <summary>
+	/// Bounds for a job system which takes part in elastic thread balancing.
+	/// Idle workers are lent from under-loaded job systems to backlogged elastic ones
+	/// by 'JobSystemManager::Update'. A lent worker still owns its home job system and
+	/// falls back to it when the job system it is lent to runs dry.
+	/// </summary>
+	struct JobSystemElasticOptions
+	{
+		bool Enabled = false;
+		uint32_t MinThreads = 1;		// Own threads which are never lent to other job systems.
+		uint32_t MaxThreads = 0;		// Max own + borrowed threads working on this job system. 0 = no limit.
 	};
 
 	/// <summary>
@@ -73,12 +210,56 @@ namespace Insight::JS
 			return job;
 		}
 
+		// Create a job with a name shown in traces. 'name' must outlive the job, a string literal is expected.
+		template<typename Func, typename... Args>
+		static auto CreateJob(const char* name, JobPriority priority, Func func, Args... args)
+		{
+			auto job = CreateJob(priority, std::move(func), std::move(args)...);
+			job->SetName(name);
+			return job;
+		}
+
 		void ReserveThreads(uint32_t numThreads);
 		void Release();
 
 		// Jobs
 		void ScheduleJob(const JobSharedPtr job);
 		void ScheduleJob(JobPriority priority, const JobSharedPtr& job, bool GetParentJob);
+		// Schedule a job which only runs where 'affinity' allows, see JobAffinity. Its children are scheduled on this job system as normal.
+		void ScheduleJob(JobAffinity const& affinity, const JobSharedPtr& job);
+		/// <summary>
+		/// Schedule a job which must finish by 'deadline'. Jobs with a deadline are run before any job without one,
+		/// earliest deadline first (EDF). Jobs finishing late are counted in ThreadStatsSnapshot::DeadlineMisses.
+		/// </summary>
+		void ScheduleJobWithDeadline(const JobSharedPtr& job, std::chrono::steady_clock::time_point deadline);
+		/// <summary>
+		/// Schedule a job on this job system once 'delay' has passed (1ms resolution) without blocking a thread.
+		/// Timers are fired by idle workers and 'Update'. The handle can cancel the job before it is scheduled.
+		/// </summary>
+		TimerHandle ScheduleJobAfter(const JobSharedPtr& job, std::chrono::steady_clock::duration delay);
+		TimerHandle ScheduleJobAt(const JobSharedPtr& job, std::chrono::steady_clock::time_point time);
+		// Cancel a timer which has not fired yet, the job is marked canceled. Returns false if it already fired.
+		bool CancelTimer(TimerHandle const& handle);
+		/// <summary>
+		/// Run a job every 'period' (1ms resolution) until 'CancelRecurring', starting one period from now.
+		/// The same job object runs every time, so its JobResult holds the result of the latest run.
+		/// 'Wait' and 'Then' children of the job wait for the job to be cancelled and finish its last run.
+		/// Throws std::logic_error if the job is recurring already and has not been cancelled and finished.
+		/// </summary>
+		void ScheduleJobEvery(const JobSharedPtr& job, std::chrono::steady_clock::duration period, JobRecurrenceOptions options = JobRecurrenceOptions());
+		// Stop a recurring job, it finishes now or after the run in progress. Returns false if it was stopped already.
+		bool CancelRecurring(const JobSharedPtr& job);
+		/// <summary>
+		/// Schedule a job which blocks (file I/O, sleeping) on the manager's blocking thread pool.
+		/// The job's 'Then' children are scheduled back on this job system.
+		/// </summary>
+		void ScheduleBlocking(const JobSharedPtr& job);
+
+		/// <summary>
+		/// Read part of a file without blocking a thread. The returned job is scheduled on this
+		/// job system once the read completes, 'size' of 0 reads to the end of the file.
+		/// </summary>
+		JobWithResultSharedPtr<Buffer> ReadFileAsync(std::string const& path, uint64_t offset = 0, uint64_t size = 0, JobPriority priority = JobPriority::Normal);
 
 		void WaitForAll() const;
 
@@ -87,9 +268,13 @@ namespace Insight::JS
 
 		uint32_t GetPendingJobsCount() const { return m_queue.GetPendingJobsCount(); }
 		uint32_t GetRunningJobsCount() const { return m_queue.GetRunningJobsCount(); }
+		uint32_t GetPendingTimersCount() const { return m_timers.GetPendingCount() + m_overdueTimerCount.load(std::memory_order_acquire); }
 
 		// Getter
 		const uint32_t GetNumThreads() const { return m_numThreads; };
+		bool IsElastic() const { return m_elasticOptions.Enabled; }
+		const JobSystemElasticOptions& GetElasticOptions() const { return m_elasticOptions; }
+		const JobSchedulingOptions& GetSchedulingOptions() const { return m_queue.GetSchedulingOptions(); }
 		inline const std::thread::id& GetMainThreadId() const { return m_mainThreadId; }
 		const std::thread::id GetThreadId(uint64_t threadIndex) const;
 
@@ -112,6 +297,12 @@ namespace Insight::JS
 		std::vector<Thread*> m_threads;
 		std::thread::id m_mainThreadId;
 		JobQueue m_queue;
+		TimingWheel m_timers;
+		// Expired timer jobs which found the queue full, retried before the wheel's next expiries.
+		std::mutex m_overdueTimerMutex;
+		std::vector<JobSharedPtr> m_overdueTimerJobs;
+		std::atomic<uint32_t> m_overdueTimerCount = 0;
+		JobSystemElasticOptions m_elasticOptions;
 
 		// Thread
 		uint8_t GetCurrentThreadIndex() const;
@@ -119,11 +310,41 @@ namespace Insight::JS
 
 		LockFreeQueue<JobSharedPtr>* GetQueueByPriority(JobPriority priority);
 		bool GetNextJob(JobSharedPtr& job);
+		// Sets 'job' to a continuation the caller should run next, see JobQueue::FinishJob.
+		void FinishJob(JobSharedPtr& job, bool takeContinuation = true);
+		// Schedule expired timers, returns true if any were. Does nothing if another thread is already doing it.
+		bool ServiceTimers();
+		// Put a recurring job which just ran back on the timing wheel, returns false once it is stopped.
+		bool ScheduleNextRun(const JobSharedPtr& job);
 
 		friend JobSystemManager;
+		friend IJob;
 		friend class BaseCounter;
 	};
 
+	/// <summary>
+	/// Counters of every worker thread, see 'JobSystemManager::GetStats'.
+	/// </summary>
+	struct JobSystemManagerStats
+	{
+		std::vector<ThreadStatsSnapshot> Threads;			// Per worker thread, indexed like the manager's threads.
+		std::vector<ThreadStatsSnapshot> BlockingThreads;	// Per blocking thread.
+		ThreadStatsSnapshot Total;							// Sum of 'Threads' and 'BlockingThreads'.
+
+		uint32_t PendingJobs = 0;
+		uint32_t RunningJobs = 0;
+		uint64_t QueueFullEvents = 0;						// Including ScheduleJob calls from non worker threads.
+	};
+
+	/// <summary>
+	/// Latencies of every job run at one priority, see 'JobSystemManager::GetLatencyStats'.
+	/// </summary>
+	struct JobLatencyStats
+	{
+		LatencyHistogramSnapshot QueueWait;		// ScheduleJob to the job starting on a worker.
+		LatencyHistogramSnapshot RunTime;		// Job start to finish.
+	};
+
 	struct JobSystemManagerOptions
 	{
 		JobSystemManagerOptions()
@@ -134,6 +355,26 @@ namespace Insight::JS
 		// Threads & Fibers
 		uint32_t NumThreads;						// Amount of Worker Threads, default = amount of Cores
 		bool ThreadAffinity = true;					// Lock each Thread to a processor core, requires NumThreads == amount of cores
+		uint32_t NumBlockingThreads = 4;			// Threads for blocking jobs (see ScheduleBlocking). May exceed amount of cores, never pinned.
+		uint32_t AsyncIOQueueDepth = 64;			// io_uring submission queue entries for ReadFileAsync, 0 = use the blocking threads.
+
+		// Affinity (see JobAffinity), power of 2 sizes.
+		uint32_t WorkerMailboxSize = 256;			// Affine jobs waiting per worker.
+		uint32_t MainThreadMailboxSize = 1024;		// Jobs waiting for the main thread.
+
+		// Starvation protection of the main job system's queues.
+		JobSchedulingOptions Scheduling;
+
+		// Elastic job systems
+		uint32_t ElasticSampleIntervalMs = 4;		// How often Update() rebalances workers between elastic job systems.
+		float ElasticBacklogFactor = 2.0f;			// A job system is backlogged when pending jobs > working threads * factor.
+
+		// Latency histograms
+		bool RecordLatencyHistograms = true;		// Record queue wait and run time per priority for GetLatencyStats.
+
+		// Tracing
+		bool EnableTracing = false;					// Record job, wait, park and steal events for WriteChromeTrace.
+		uint32_t TraceEventsPerThread = 1 << 16;	// Ring buffer size per thread, the oldest events are overwritten.
 
 		// Other
 		bool ShutdownAfterMainCallback = true;		// Shutdown everything after Main Callback returns?
@@ -171,8 +412,11 @@ namespace Insight::JS
 
 		/// <summary>
 		/// Create a new job system and reserving threads from the main pool.
+		/// With 'elasticOptions.Enabled' the job system can borrow idle workers from
+		/// other job systems while it is backlogged, and lend its own idle workers out.
 		/// </summary>
-		std::shared_ptr<JobSystem> CreateLocalJobSystem(uint32_t numThreads);
+		std::shared_ptr<JobSystem> CreateLocalJobSystem(uint32_t numThreads, JobSystemElasticOptions elasticOptions = JobSystemElasticOptions(),
+														JobSchedulingOptions schedulingOptions = JobSchedulingOptions());
 		bool ReseveThreads(uint32_t const& numThreads);
 		bool ReseveThreads(JobSystem& jobSystem, uint32_t const& numThreads);
 		void ReleaseJobSystem(JobSystem& jobSystem);
@@ -187,6 +431,15 @@ namespace Insight::JS
 			return job;
 		}
 
+		// Create a job with a name shown in traces. 'name' must outlive the job, a string literal is expected.
+		template<typename Func, typename... Args>
+		static auto CreateJob(const char* name, JobPriority priority, Func func, Args... args)
+		{
+			auto job = CreateJob(priority, std::move(func), std::move(args)...);
+			job->SetName(name);
+			return job;
+		}
+
 		// Shutdown all Jobs/Threads/Fibers
 		// blocking => wait for threads to exit
 		void Shutdown(bool blocking);
@@ -194,17 +447,84 @@ namespace Insight::JS
 		// Jobs
 		void ScheduleJob(const JobSharedPtr job);
 		void ScheduleJob(JobPriority priority, const JobSharedPtr& job, bool GetParentJob);
+		// Schedule a job on the main job system which only runs where 'affinity' allows, see JobAffinity.
+		void ScheduleJob(JobAffinity const& affinity, const JobSharedPtr& job);
+		// Schedule a job which must finish by 'deadline' on the main job system, see JobSystem::ScheduleJobWithDeadline.
+		void ScheduleJobWithDeadline(const JobSharedPtr& job, std::chrono::steady_clock::time_point deadline);
+		// Schedule a job on the main job system after a delay, see JobSystem::ScheduleJobAfter.
+		TimerHandle ScheduleJobAfter(const JobSharedPtr& job, std::chrono::steady_clock::duration delay);
+		TimerHandle ScheduleJobAt(const JobSharedPtr& job, std::chrono::steady_clock::time_point time);
+		bool CancelTimer(TimerHandle const& handle);
+		// Run a job every 'period' on the main job system, see JobSystem::ScheduleJobEvery.
+		void ScheduleJobEvery(const JobSharedPtr& job, std::chrono::steady_clock::duration period, JobRecurrenceOptions options = JobRecurrenceOptions());
+		bool CancelRecurring(const JobSharedPtr& job);
+		/// <summary>
+		/// Schedule a job which blocks (file I/O, sleeping) on the blocking thread pool so it
+		/// never occupies a compute worker. The job's 'Then' children run on the main job system.
+		/// </summary>
+		void ScheduleBlocking(const JobSharedPtr& job);
 
-		void WaitForAll() const;
+		// Read part of a file without blocking a thread, continuations run on the main job system.
+		JobWithResultSharedPtr<Buffer> ReadFileAsync(std::string const& path, uint64_t offset = 0, uint64_t size = 0, JobPriority priority = JobPriority::Normal);
 
-		// Small update function.
+		// Wait for the jobs of every job system to finish. Runs the jobs waiting for the main thread when called from it.
+		void WaitForAll();
+		/// <summary>
+		/// Run one pending job of the calling worker's job system, returns false if there is none or the
+		/// calling thread is not a worker. Waiting on a job or result from a job helps with this, so a job
+		/// waiting on another job can't starve the pool.
+		/// </summary>
+		static bool RunPendingJob();
+
+		// Small update function. Runs the jobs waiting for the main thread and rebalances workers between elastic job systems.
 		void Update(uint32_t  const& jobsToFree = 64);
+		// Update which stops running main thread jobs once 'mainThreadBudget' is used up, the rest run next time.
+		void Update(MainThreadBudget const& mainThreadBudget, uint32_t const& jobsToFree = 64);
+
+		/// <summary>
+		/// Run 'func' on the main thread during a later 'Update' or 'WaitForAll'. Safe to call from any thread,
+		/// so workers can hand results to main thread only systems (UI, scene graph) without locks.
+		/// The returned job can be waited on or continued with 'Then', its children run on the workers.
+		/// </summary>
+		template<typename Func, typename... Args>
+		auto PostToMainThread(Func func, Args... args)
+		{
+			auto job = CreateJob(JobPriority::Normal, std::move(func), std::move(args)...);
+			ScheduleJob(JobAffinity::MainThread(), job);
+			return job;
+		}
 
 		// Getter
 		inline bool IsShuttingDown() const { return m_shuttingDown.load(std::memory_order_acquire); };
 		const uint32_t GetNumThreads() const { return m_current_options.NumThreads; };
+		uint32_t GetNumBlockingThreads() const { return m_current_options.NumBlockingThreads; };
 		inline const std::thread::id& GetMainThreadId() const { return m_mainThreadId; }
+		JobSystem& GetMainJobSystem() { return m_mainJobSystem; }
 		uint32_t GetPendingJobsCount() const;
+		uint32_t GetPendingBlockingJobsCount() const;
+		uint32_t GetRunningJobsCount() const;
+		/// <summary>
+		/// Snapshot of every worker's counters. Safe to call from any thread while the workers run,
+		/// counters are read individually so a snapshot may be slightly behind the workers.
+		/// </summary>
+		JobSystemManagerStats GetStats() const;
+		/// <summary>
+		/// Queue wait and run time histograms of every job executed at 'priority' so far,
+		/// merged from all workers. Empty unless 'JobSystemManagerOptions::RecordLatencyHistograms' is set.
+		/// </summary>
+		JobLatencyStats GetLatencyStats(JobPriority priority) const;
+		/// <summary>
+		/// Hardware counters of every job executed so far, summed per job name (unnamed jobs are "Job").
+		/// Empty unless the library is built with JS_ENABLE_PERF_COUNTERS and perf_event_open is permitted.
+		/// </summary>
+		std::map<std::string, PerfCounterValues> GetPerfCounters() const;
+
+		/// <summary>
+		/// Write the recorded trace (see 'JobSystemManagerOptions::EnableTracing') as Chrome Trace Event JSON,
+		/// open it in chrome://tracing or ui.perfetto.dev. Can be called while the workers run.
+		/// </summary>
+		bool WriteChromeTrace(std::string const& path) const;
+		void WriteChromeTrace(std::ostream& stream) const;
 
 		//inline uint32_t GetUseableThreads() const { return static_cast<uint32_t>(m_useableThreads.size()); }
 		//inline uint32_t GetReservedThreads() const { return static_cast<uint32_t>(m_reservedThreads.size()); }
@@ -217,6 +537,7 @@ namespace Insight::JS
 
 		// Threads
 		Thread* m_allThreads = nullptr;
+		Thread* m_blockingThreads = nullptr;
 		std::thread::id m_mainThreadId;
 
 		// Thread
@@ -227,13 +548,40 @@ namespace Insight::JS
 		bool GetNextJob(JobSharedPtr& job);
 
 		JobSystem m_mainJobSystem;
+		JobSystem m_blockingJobSystem;
 		std::vector<std::shared_ptr<JobSystem>> m_jobSystems;
+		AsyncIO m_asyncIO;
+
+		// Affinity. Mailboxes of affine jobs, indexed by worker thread index.
+		std::vector<std::unique_ptr<LockFreeQueue<JobSharedPtr>>> m_workerMailboxes;
+		std::unique_ptr<LockFreeQueue<JobSharedPtr>> m_mainThreadMailbox;
+
+		// Tracing. The main thread records into its own buffer, workers into their Thread's.
+		std::unique_ptr<TraceBuffer> m_mainThreadTrace;
+		TraceClockCalibration m_clockStart;		// Converts TraceClock ticks of traces and latency histograms to time.
+
+	private:
+		void PostToMailbox(JobAffinity const& affinity, const JobSharedPtr& job);
+		// Dequeue an affine job and count it as running on its job system.
+		static bool TakeMailboxJob(LockFreeQueue<JobSharedPtr>& mailbox, JobSharedPtr& job);
+		// Returns the number of jobs run.
+		uint32_t RunMainThreadJobs(MainThreadBudget const& budget);
+
+		void BalanceElasticJobSystems();
+		uint32_t GetWorkingThreadCount(JobSystem const& jobSystem) const;
+		uint32_t GetLentThreadCount(JobSystem const& jobSystem) const;
+		bool IsBacklogged(JobSystem const& jobSystem) const;
 
 	private:
 		Callback m_mainCallback = nullptr;
+		std::chrono::steady_clock::time_point m_lastElasticSample;
 
+		// Run a dequeued job and the continuations it hands over, recording stats, trace and latencies on 'thread'.
+		// Returns the number of jobs run.
+		static uint32_t ExecuteJob(Thread& thread, JobSystem& system, JobSharedPtr& job);
 		static void ThreadCallback_Worker(Thread* thread);
 
+		friend JobSystem;
 		friend class BaseCounter;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <vector>
+
+namespace Insight::JS
+{
+	/// <summary>
+	/// Log-linear bucket layout shared by LatencyHistogram and its snapshots (the HdrHistogram layout).
+	/// Values below 64 have a bucket each, above that every power of two is split into 32 buckets,
+	/// so a bucket is within ~3% of any value in it. Values above 2^48 go into the last bucket.
+	/// </summary>
+	struct LatencyBuckets
+	{
+		static constexpr uint32_t c_LinearBuckets = 64;
+		static constexpr uint32_t c_SubBucketBits = 5;
+		static constexpr uint32_t c_SubBuckets = 1u << c_SubBucketBits;
+		static constexpr uint32_t c_MaxBit = 47;
+		static constexpr uint32_t c_NumBuckets = c_LinearBuckets + (c_MaxBit - c_SubBucketBits) * c_SubBuckets;
+
+		static uint32_t GetIndex(uint64_t value)
+		{
+			if (value < c_LinearBuckets)
+			{
+				return static_cast<uint32_t>(value);
+			}
+			uint32_t highestBit = 63;
+			while ((value >> highestBit) == 0)
+			{
+				--highestBit;
+			}
+			if (highestBit > c_MaxBit)
+			{
+				return c_NumBuckets - 1;
+			}
+			uint32_t const shift = highestBit - c_SubBucketBits;
+			uint32_t const subBucket = static_cast<uint32_t>(value >> shift) - c_SubBuckets;
+			return c_LinearBuckets + (highestBit - c_SubBucketBits - 1) * c_SubBuckets + subBucket;
+		}
+
+		// Highest value which lands in bucket 'index'.
+		static uint64_t GetUpperValue(uint32_t index)
+		{
+			if (index < c_LinearBuckets)
+			{
+				return index;
+			}
+			uint32_t const shift = (index - c_LinearBuckets) / c_SubBuckets + 1;
+			uint64_t const subBucket = (index - c_LinearBuckets) % c_SubBuckets + c_SubBuckets;
+			return ((subBucket + 1) << shift) - 1;
+		}
+	};
+
+	/// <summary>
+	/// Copy of a LatencyHistogram, or the merge of several. Values are TraceClock ticks,
+	/// the getters convert them to nanoseconds.
+	/// </summary>
+	struct LatencyHistogramSnapshot
+	{
+		std::vector<uint64_t> Counts = std::vector<uint64_t>(LatencyBuckets::c_NumBuckets, 0);
+		uint64_t TotalCount = 0;
+		uint64_t SumTicks = 0;
+		uint64_t MaxTicks = 0;
+		double NanosecondsPerTick = 1.0;
+
+		LatencyHistogramSnapshot& operator+=(LatencyHistogramSnapshot const& other)
+		{
+			for (uint32_t i = 0; i < LatencyBuckets::c_NumBuckets; ++i)
+			{
+				Counts[i] += other.Counts[i];
+			}
+			TotalCount += other.TotalCount;
+			SumTicks += other.SumTicks;
+			MaxTicks = std::max(MaxTicks, other.MaxTicks);
+			return *this;
+		}
+
+		uint64_t GetCount() const { return TotalCount; }
+		double GetMean() const { return TotalCount > 0 ? static_cast<double>(SumTicks) / static_cast<double>(TotalCount) * NanosecondsPerTick : 0.0; }
+		double GetMax() const { return static_cast<double>(MaxTicks) * NanosecondsPerTick; }
+
+		// Smallest value which 'percentile' (0 - 100) percent of recorded values are at or below.
+		double GetPercentile(double percentile) const
+		{
+			if (TotalCount == 0)
+			{
+				return 0.0;
+			}
+			uint64_t const target = std::max<uint64_t>(1, static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(TotalCount) + 0.5));
+			uint64_t count = 0;
+			for (uint32_t i = 0; i < LatencyBuckets::c_NumBuckets; ++i)
+			{
+				count += Counts[i];
+				if (count >= target)
+				{
+					return static_cast<double>(std::min(LatencyBuckets::GetUpperValue(i), MaxTicks)) * NanosecondsPerTick;
+				}
+			}
+			return GetMax();
+		}
+	};
+
+	/// <summary>
+	/// Histogram written by a single thread without read-modify-write atomics, readable from any thread.
+	/// </summary>
+	class LatencyHistogram
+	{
+	public:
+		LatencyHistogram()
+		{
+			for (std::atomic<uint64_t>& count : m_counts)
+			{
+				count.store(0, std::memory_order_relaxed);
+			}
+		}
+
+		// Only call from the owning thread.
+		void Record(uint64_t ticks)
+		{
+			Increment(m_counts[LatencyBuckets::GetIndex(ticks)], 1);
+			Increment(m_sumTicks, ticks);
+			if (ticks > m_maxTicks.load(std::memory_order_relaxed))
+			{
+				m_maxTicks.store(ticks, std::memory_order_relaxed);
+			}
+		}
+
+		void AddTo(LatencyHistogramSnapshot& snapshot) const
+		{
+			// The total is summed from the buckets so it always matches them.
+			LatencyHistogramSnapshot mine;
+			for (uint32_t i = 0; i < LatencyBuckets::c_NumBuckets; ++i)
+			{
+				mine.Counts[i] = m_counts[i].load(std::memory_order_relaxed);
+				mine.TotalCount += mine.Counts[i];
+			}
+			mine.SumTicks = m_sumTicks.load(std::memory_order_relaxed);
+			mine.MaxTicks = m_maxTicks.load(std::memory_order_relaxed);
+			snapshot += mine;
+		}
+
+	private:
+		static void Increment(std::atomic<uint64_t>& counter, uint64_t value)
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+
+	private:
+		std::array<std::atomic<uint64_t>, LatencyBuckets::c_NumBuckets> m_counts;
+		std::atomic<uint64_t> m_sumTicks = 0;
+		std::atomic<uint64_t> m_maxTicks = 0;
+	};
+
+	/// <summary>
+	/// A worker's queue wait (schedule to start) and run time (start to finish) histograms,
+	/// indexed by JobPriority.
+	/// </summary>
+	struct JobLatencyHistograms
+	{
+		std::array<LatencyHistogram, 3> QueueWait;
+		std::array<LatencyHistogram, 3> RunTime;
+	};
+}
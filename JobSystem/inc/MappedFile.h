@@ -0,0 +1,195 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mutex>
+#include "JobSystemManager.h"
+
+namespace Insight::JS
+{
+	/// <summary>
+	/// Read only memory mapping of a whole file.
+	/// </summary>
+	class MappedFile : public NonCopyable
+	{
+	public:
+		enum class Advice : uint8_t
+		{
+			Normal,
+			Sequential,		// Pages will be read front to back, read ahead aggressively.
+			WillNeed,		// Start reading pages in now.
+			DontNeed,		// Pages may be dropped from memory.
+		};
+
+		MappedFile() = default;
+		~MappedFile();
+
+		bool Open(std::string const& path);
+		void Close();
+
+		// Hint the OS how a range of the mapping will be used. Ignored where not supported.
+		void Advise(uint64_t offset, uint64_t size, Advice advice) const;
+
+		bool IsOpen() const { return m_isOpen; }
+		const uint8_t* GetData() const { return m_data; }
+		uint64_t GetSize() const { return m_size; }
+
+		static uint64_t GetPageSize();
+
+	private:
+		const uint8_t* m_data = nullptr;
+		uint64_t m_size = 0;
+		bool m_isOpen = false;
+#ifdef _WIN32
+		void* m_fileHandle = nullptr;
+		void* m_mappingHandle = nullptr;
+#else
+		int m_fd = -1;
+#endif
+	};
+
+	/// <summary>
+	/// View of part of a mapped file handed to a chunk job. Points straight into the mapping.
+	/// </summary>
+	struct MappedFileChunk
+	{
+		const uint8_t* Data = nullptr;
+		uint64_t Offset = 0;
+		uint64_t Size = 0;
+		uint32_t Index = 0;
+
+		std::string_view GetView() const { return std::string_view(reinterpret_cast<const char*>(Data), static_cast<size_t>(Size)); }
+	};
+
+	struct MappedFileChunkOptions
+	{
+		uint64_t ChunkSize = 4 * 1024 * 1024;	// Rounded up to a multiple of the page size.
+		bool SplitOnDelimiter = false;			// Move every chunk end to just past the next 'Delimiter' so records are never split.
+		char Delimiter = '\n';
+		bool PrefetchNextChunk = true;			// Each job asks the OS to read in the following chunk before processing its own.
+		bool Ordered = false;					// Deliver results to 'onResult' in chunk order.
+		JobPriority Priority = JobPriority::Normal;
+	};
+
+	/// <summary>
+	/// Split a mapped file into page aligned chunks.
+	/// </summary>
+	std::vector<MappedFileChunk> SplitMappedFile(MappedFile const& file, MappedFileChunkOptions const& options);
+
+	/// <summary>
+	/// Create (but do not schedule) one job per chunk calling 'func(MappedFileChunk const&)'.
+	/// </summary>
+	template<typename Func>
+	auto CreateMappedFileJobs(MappedFile const& file, std::vector<MappedFileChunk> const& chunks, MappedFileChunkOptions const& options, Func func)
+	{
+		using ResultType = std::invoke_result_t<Func, MappedFileChunk const&>;
+
+		std::vector<JobWithResultSharedPtr<ResultType>> jobs;
+		jobs.reserve(chunks.size());
+		for (size_t i = 0; i < chunks.size(); ++i)
+		{
+			MappedFileChunk chunk = chunks[i];
+			MappedFileChunk nextChunk = i + 1 < chunks.size() ? chunks[i + 1] : MappedFileChunk();
+			bool const prefetch = options.PrefetchNextChunk;
+			const MappedFile* mappedFile = &file;
+			jobs.push_back(JobSystem::CreateJob(options.Priority, [func, chunk, nextChunk, prefetch, mappedFile]()
+												{
+													if (prefetch && nextChunk.Size > 0)
+													{
+														mappedFile->Advise(nextChunk.Offset, nextChunk.Size, MappedFile::Advice::WillNeed);
+													}
+													return func(chunk);
+												}));
+		}
+		return jobs;
+	}
+
+	/// <summary>
+	/// Schedule one job per chunk of 'file' calling 'func(MappedFileChunk const&)'. Each chunk's
+	/// result is in its job's 'JobResult'. 'file' must stay open until all jobs have finished.
+	/// </summary>
+	template<typename Func>
+	auto ProcessMappedFile(JobSystem& jobSystem, MappedFile const& file, MappedFileChunkOptions const& options, Func func)
+	{
+		auto jobs = CreateMappedFileJobs(file, SplitMappedFile(file, options), options, func);
+		for (auto const& job : jobs)
+		{
+			jobSystem.ScheduleJob(job);
+		}
+		return jobs;
+	}
+
+	/// <summary>
+	/// Process every chunk of 'file' on 'jobSystem' and pass each chunk's result to
+	/// 'onResult(MappedFileChunk const&, ResultType const&)'. With 'options.Ordered' the results
+	/// are delivered in chunk order, otherwise as soon as each chunk finishes. 'onResult' calls
+	/// never overlap. A chunk whose function threw is skipped, and an exception from 'onResult' is dropped.
+	/// Returns the chunk jobs, results and chunk exceptions stay readable through their 'JobResult'.
+	/// </summary>
+	template<typename Func, typename OnResult>
+	auto ProcessMappedFile(JobSystem& jobSystem, MappedFile const& file, MappedFileChunkOptions const& options, Func func, OnResult onResult)
+	{
+		using ResultType = std::invoke_result_t<Func, MappedFileChunk const&>;
+		static_assert(!std::is_void_v<ResultType>, "[ProcessMappedFile] Chunk results can only be delivered from non void chunk functions.");
+
+		struct DeliveryState
+		{
+			std::mutex Mutex;
+			std::vector<MappedFileChunk> Chunks;
+			std::vector<JobWithResultSharedPtr<ResultType>> Jobs;
+			std::vector<bool> Finished;
+			size_t NextToDeliver = 0;
+			size_t Delivered = 0;
+		};
+
+		std::shared_ptr<DeliveryState> state = std::make_shared<DeliveryState>();
+		state->Chunks = SplitMappedFile(file, options);
+		auto jobs = CreateMappedFileJobs(file, state->Chunks, options, func);
+		state->Jobs = jobs;
+		state->Finished.resize(jobs.size(), false);
+
+		bool const ordered = options.Ordered;
+		for (size_t i = 0; i < jobs.size(); ++i)
+		{
+			// The continuation runs once the chunk's result has been set.
+			jobs[i]->Then([state, onResult, ordered, i]() mutable
+						  {
+							  std::lock_guard lock(state->Mutex);
+							  // A chunk which threw, or whose 'onResult' threw, still counts as delivered so later
+							  // chunks are delivered and the jobs are released.
+							  auto deliver = [&state, &onResult](size_t index)
+							  {
+								  try
+								  {
+									  onResult(state->Chunks[index], state->Jobs[index]->GetResult().GetResult());
+								  }
+								  catch (...)
+								  { }
+								  ++state->Delivered;
+							  };
+
+							  if (!ordered)
+							  {
+								  deliver(i);
+							  }
+							  else
+							  {
+								  state->Finished[i] = true;
+								  while (state->NextToDeliver < state->Jobs.size() && state->Finished[state->NextToDeliver])
+								  {
+									  deliver(state->NextToDeliver++);
+								  }
+							  }
+							  // Everything delivered, drop the references back to the jobs.
+							  if (state->Delivered == state->Jobs.size())
+							  {
+								  state->Jobs.clear();
+							  }
+						  });
+			jobSystem.ScheduleJob(jobs[i]);
+		}
+		return jobs;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include "TaskGroup.h"
+
+namespace Insight::JS
+{
+	/// <summary>
+	/// Split [begin, end) into jobs of 'grainSize' indices, call 'func(index)' for every index
+	/// and wait for all of them to finish.
+	/// </summary>
+	template<typename Func>
+	void ParallelFor(JobSystem& jobSystem, uint64_t begin, uint64_t end, uint64_t grainSize, Func func, JobPriority priority = JobPriority::Normal)
+	{
+		if (begin >= end)
+		{
+			return;
+		}
+		grainSize = std::max<uint64_t>(grainSize, 1);
+
+		TaskGroup group(jobSystem, priority);
+		for (uint64_t blockBegin = begin; blockBegin < end; blockBegin += grainSize)
+		{
+			uint64_t const blockEnd = std::min(blockBegin + grainSize, end);
+			group.Run([func, blockBegin, blockEnd]()
+					  {
+						  for (uint64_t i = blockBegin; i < blockEnd; ++i)
+						  {
+							  func(i);
+						  }
+					  });
+		}
+		group.Wait();
+	}
+
+	/// <summary>
+	/// Runs numbered blocks of work on a job system. One job per worker and the calling thread claim
+	/// blocks from a shared counter and the caller only waits for blocks to finish, not for the jobs to
+	/// start, so a sleeping or busy worker never delays it.
+	/// </summary>
+	struct ParallelBlocks
+	{
+		// Shared with the jobs of one Run, which may start after it returned.
+		struct State
+		{
+			std::atomic<uint64_t> NextBlock = 0;
+			std::atomic<uint64_t> FinishedBlocks = 0;
+			std::atomic<bool> HasException = false;
+			std::exception_ptr Exception;
+		};
+
+		// Call 'func(block)' for every block in [0, blockCount). Rethrows the first exception once every block ran.
+		template<typename Func>
+		static void Run(JobSystem& jobSystem, JobPriority priority, uint64_t blockCount, Func const& func)
+		{
+			if (blockCount == 0)
+			{
+				return;
+			}
+
+			std::shared_ptr<State> state = std::make_shared<State>();
+			// 'func' is only used while blocks are unfinished, so the caller is still waiting and it is alive.
+			auto runBlocks = [state, &func, blockCount]()
+			{
+				for (uint64_t block = state->NextBlock.fetch_add(1, std::memory_order_relaxed); block < blockCount; block = state->NextBlock.fetch_add(1, std::memory_order_relaxed))
+				{
+					try
+					{
+						func(block);
+					}
+					catch (...)
+					{
+						if (!state->HasException.exchange(true, std::memory_order_acq_rel))
+						{
+							state->Exception = std::current_exception();
+						}
+					}
+					state->FinishedBlocks.fetch_add(1, std::memory_order_acq_rel);
+				}
+			};
+
+			uint64_t const helpers = std::min<uint64_t>(blockCount - 1, jobSystem.GetNumThreads());
+			for (uint64_t i = 0; i < helpers; ++i)
+			{
+				try
+				{
+					jobSystem.ScheduleJob(JobSystem::CreateJob(priority, runBlocks));
+				}
+				catch (std::overflow_error const&)
+				{
+					// The queue is full, the blocks run on fewer threads.
+					break;
+				}
+			}
+			runBlocks();
+			while (state->FinishedBlocks.load(std::memory_order_acquire) < blockCount)
+			{
+				if (!JobSystemManager::RunPendingJob())
+				{
+					std::this_thread::yield();
+				}
+			}
+			if (state->Exception)
+			{
+				std::rethrow_exception(state->Exception);
+			}
+		}
+	};
+
+	// Default ParallelForBatched alignment: a 64 byte cache line of floats, two AVX2 or four SSE vectors.
+	static constexpr uint64_t c_DefaultBatchLanes = 16;
+
+	/// <summary>
+	/// Call 'func(blockBegin, blockEnd)' for contiguous blocks of [begin, end), so the loop over a block can
+	/// be vectorised. Block sizes are 'batchSize' rounded up to a multiple of 'lanes' and blocks start at
+	/// multiples of 'lanes' (except the first), so when element 0 of the arrays is aligned every block starts
+	/// on a vector and, with 'lanes' * element size a multiple of 64, no two blocks write the same cache line.
+	/// Only the first and last block can have a partial vector. 'batchSize' of 0 gives every worker about 4 blocks.
+	/// </summary>
+	template<typename Func>
+	void ParallelForBatched(JobSystem& jobSystem, uint64_t begin, uint64_t end, uint64_t batchSize, Func func, JobPriority priority = JobPriority::Normal, uint64_t lanes = c_DefaultBatchLanes)
+	{
+		if (begin >= end)
+		{
+			return;
+		}
+		lanes = std::max<uint64_t>(lanes, 1);
+		if (batchSize == 0)
+		{
+			batchSize = (end - begin) / (std::max<uint64_t>(jobSystem.GetNumThreads(), 1) * 4);
+		}
+		batchSize = (std::max(batchSize, lanes) + lanes - 1) / lanes * lanes;
+
+		uint64_t const alignedBegin = begin - begin % lanes;
+		uint64_t const blockCount = (end - alignedBegin + batchSize - 1) / batchSize;
+		ParallelBlocks::Run(jobSystem, priority, blockCount, [&func, begin, end, alignedBegin, batchSize](uint64_t block)
+							{
+								uint64_t const blockBegin = std::max(alignedBegin + block * batchSize, begin);
+								uint64_t const blockEnd = std::min(alignedBegin + (block + 1) * batchSize, end);
+								func(blockBegin, blockEnd);
+							});
+	}
+}
@@ -0,0 +1,343 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "ParallelFor.h"
+#include "ScratchBuffer.h"
+
+namespace Insight::JS
+{
+	/// <summary>
+	/// Building blocks of ParallelSort and ParallelPartition. Ranges are split into a few blocks per
+	/// worker of the job system, small ranges run on the calling thread.
+	/// </summary>
+	struct ParallelAlgorithms
+	{
+		static constexpr size_t c_SerialThreshold = 1 << 14;
+		static constexpr size_t c_MinBlockSize = 1 << 12;
+
+		static size_t GetBlockCount(JobSystem const& jobSystem, size_t count)
+		{
+			size_t const maxBlocks = std::max<size_t>(jobSystem.GetNumThreads(), 1) * 4;
+			return std::clamp<size_t>(count / c_MinBlockSize, 1, maxBlocks);
+		}
+
+		static size_t GetBlockBegin(size_t block, size_t blockCount, size_t count)
+		{
+			return count / blockCount * block + std::min(block, count % blockCount);
+		}
+
+		// Call 'func(block, begin, end)' for every block, see ParallelBlocks.
+		template<typename Func>
+		static void ForEachBlock(JobSystem& jobSystem, JobPriority priority, size_t blockCount, size_t count, Func const& func)
+		{
+			ParallelBlocks::Run(jobSystem, priority, blockCount, [&func, blockCount, count](uint64_t block)
+								{
+									func(block, GetBlockBegin(block, blockCount, count), GetBlockBegin(block + 1, blockCount, count));
+								});
+		}
+
+		// Keys ordered as unsigned integers, signed keys have their sign bit flipped.
+		template<typename Key>
+		static auto ToRadixKey(Key key)
+		{
+			static_assert(std::is_integral_v<Key> && !std::is_same_v<Key, bool>, "Radix sort keys must be integers.");
+			using UnsignedKey = std::make_unsigned_t<Key>;
+			if constexpr (std::is_signed_v<Key>)
+			{
+				return static_cast<UnsignedKey>(static_cast<UnsignedKey>(key) ^ (UnsignedKey(1) << (sizeof(Key) * 8 - 1)));
+			}
+			else
+			{
+				return key;
+			}
+		}
+
+		/// <summary>
+		/// Stable LSD radix sort, 8 bits per pass. Each pass counts digits per block in parallel, a prefix sum
+		/// over (digit, block) gives every block its own output ranges and the blocks scatter in parallel.
+		/// Passes where every key has the same digit are skipped, so small keys in wide types sort in fewer passes.
+		/// </summary>
+		template<typename T, typename KeyFunc>
+		static void RadixSort(JobSystem& jobSystem, T* data, size_t count, KeyFunc const& keyFunc, JobPriority priority)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "Radix sort copies elements through scratch memory.");
+			using Key = decltype(ToRadixKey(keyFunc(*data)));
+			if (count < c_SerialThreshold)
+			{
+				std::stable_sort(data, data + count, [&keyFunc](T const& a, T const& b) { return ToRadixKey(keyFunc(a)) < ToRadixKey(keyFunc(b)); });
+				return;
+			}
+
+			size_t const blockCount = GetBlockCount(jobSystem, count);
+			ScratchBuffer scratch(count * sizeof(T));
+			// 256 counters per block is 2KB, blocks never share a cache line.
+			ScratchBuffer histogramScratch(blockCount * 256 * sizeof(size_t));
+			size_t* const histograms = histogramScratch.As<size_t>();
+			T* src = data;
+			T* dst = scratch.As<T>();
+			for (uint32_t shift = 0; shift < sizeof(Key) * 8; shift += 8)
+			{
+				ForEachBlock(jobSystem, priority, blockCount, count, [&](size_t block, size_t begin, size_t end)
+							 {
+								 size_t* histogram = histograms + block * 256;
+								 std::fill(histogram, histogram + 256, 0);
+								 for (size_t i = begin; i < end; ++i)
+								 {
+									 ++histogram[(ToRadixKey(keyFunc(src[i])) >> shift) & 0xFF];
+								 }
+							 });
+
+				bool skipPass = false;
+				size_t offset = 0;
+				for (uint32_t digit = 0; digit < 256; ++digit)
+				{
+					size_t const digitBegin = offset;
+					for (size_t block = 0; block < blockCount; ++block)
+					{
+						size_t const digitCount = histograms[block * 256 + digit];
+						histograms[block * 256 + digit] = offset;
+						offset += digitCount;
+					}
+					skipPass |= offset - digitBegin == count;
+				}
+				if (skipPass)
+				{
+					continue;
+				}
+
+				ForEachBlock(jobSystem, priority, blockCount, count, [&](size_t block, size_t begin, size_t end)
+							 {
+								 size_t* offsets = histograms + block * 256;
+								 for (size_t i = begin; i < end; ++i)
+								 {
+									 dst[offsets[(ToRadixKey(keyFunc(src[i])) >> shift) & 0xFF]++] = src[i];
+								 }
+							 });
+				std::swap(src, dst);
+			}
+
+			if (src != data)
+			{
+				ForEachBlock(jobSystem, priority, blockCount, count, [&](size_t, size_t begin, size_t end)
+							 {
+								 std::copy(src + begin, src + end, data + begin);
+							 });
+			}
+		}
+
+		/// <summary>
+		/// Merge two sorted ranges into 'out'. Big merges split at the middle of the longer range and its
+		/// lower bound in the other, the two halves merge in parallel.
+		/// </summary>
+		template<typename InIt, typename OutIt, typename Compare>
+		static void Merge(TaskGroup& group, InIt first1, InIt last1, InIt first2, InIt last2, OutIt out, Compare const& comp)
+		{
+			while (static_cast<size_t>((last1 - first1) + (last2 - first2)) > c_SerialThreshold)
+			{
+				if (last1 - first1 < last2 - first2)
+				{
+					std::swap(first1, first2);
+					std::swap(last1, last2);
+				}
+				InIt const mid1 = first1 + (last1 - first1) / 2;
+				InIt const mid2 = std::lower_bound(first2, last2, *mid1, comp);
+				group.Run([&group, &comp, first1, mid1, first2, mid2, out]()
+						  {
+							  Merge(group, first1, mid1, first2, mid2, out, comp);
+						  });
+				out += (mid1 - first1) + (mid2 - first2);
+				first1 = mid1;
+				first2 = mid2;
+			}
+			std::merge(std::make_move_iterator(first1), std::make_move_iterator(last1), std::make_move_iterator(first2), std::make_move_iterator(last2), out, comp);
+		}
+
+		// Merge pairs of sorted runs 'runBlocks' blocks long from 'src' into 'dst'.
+		template<typename InIt, typename OutIt, typename Compare>
+		static void MergeRuns(JobSystem& jobSystem, JobPriority priority, InIt src, OutIt dst, size_t count, size_t blockCount, size_t runBlocks, Compare const& comp)
+		{
+			TaskGroup group(jobSystem, priority);
+			for (size_t block = 0; block < blockCount; block += runBlocks * 2)
+			{
+				size_t const begin = GetBlockBegin(block, blockCount, count);
+				size_t const mid = GetBlockBegin(std::min(block + runBlocks, blockCount), blockCount, count);
+				size_t const end = GetBlockBegin(std::min(block + runBlocks * 2, blockCount), blockCount, count);
+				group.Run([&group, &comp, src, dst, begin, mid, end]()
+						  {
+							  Merge(group, src + begin, src + mid, src + mid, src + end, dst + begin, comp);
+						  });
+			}
+			group.Wait();
+		}
+
+		/// <summary>
+		/// Sort blocks in parallel, then merge runs pairwise, ping-ponging between the range and scratch.
+		/// </summary>
+		template<typename It, typename Scratch, typename Compare>
+		static void MergeSort(JobSystem& jobSystem, It first, Scratch scratch, size_t count, size_t blockCount, Compare const& comp, JobPriority priority)
+		{
+			bool inScratch = false;
+			for (size_t runBlocks = 1; runBlocks < blockCount; runBlocks *= 2)
+			{
+				if (inScratch)
+				{
+					MergeRuns(jobSystem, priority, scratch, first, count, blockCount, runBlocks, comp);
+				}
+				else
+				{
+					MergeRuns(jobSystem, priority, first, scratch, count, blockCount, runBlocks, comp);
+				}
+				inScratch = !inScratch;
+			}
+			if (inScratch)
+			{
+				ForEachBlock(jobSystem, priority, blockCount, count, [&](size_t, size_t begin, size_t end)
+							 {
+								 std::move(scratch + begin, scratch + end, first + begin);
+							 });
+			}
+		}
+	};
+
+	/// <summary>
+	/// Sort [first, last) by 'comp' on 'jobSystem', not stable. Blocks are sorted in parallel and then merged
+	/// with parallel merges. Trivially copyable elements in contiguous memory use pooled scratch memory,
+	/// other elements a temporary vector.
+	/// </summary>
+	template<typename It, typename Compare>
+	void ParallelSort(JobSystem& jobSystem, It first, It last, Compare comp, JobPriority priority = JobPriority::Normal)
+	{
+		using T = typename std::iterator_traits<It>::value_type;
+		size_t const count = static_cast<size_t>(last - first);
+		if (count < ParallelAlgorithms::c_SerialThreshold)
+		{
+			std::sort(first, last, comp);
+			return;
+		}
+
+		size_t const blockCount = ParallelAlgorithms::GetBlockCount(jobSystem, count);
+		ParallelAlgorithms::ForEachBlock(jobSystem, priority, blockCount, count, [&](size_t, size_t begin, size_t end)
+										 {
+											 std::sort(first + begin, first + end, comp);
+										 });
+		if (blockCount == 1)
+		{
+			return;
+		}
+
+		if constexpr (std::is_trivially_copyable_v<T> && std::contiguous_iterator<It>)
+		{
+			ScratchBuffer scratch(count * sizeof(T));
+			ParallelAlgorithms::MergeSort(jobSystem, std::to_address(first), scratch.As<T>(), count, blockCount, comp, priority);
+		}
+		else
+		{
+			std::vector<T> scratch(count);
+			ParallelAlgorithms::MergeSort(jobSystem, first, scratch.begin(), count, blockCount, comp, priority);
+		}
+	}
+
+	/// <summary>
+	/// Sort [first, last) in ascending order. Integers in contiguous memory use a parallel radix sort,
+	/// everything else ParallelSort with std::less.
+	/// </summary>
+	template<typename It>
+	void ParallelSort(JobSystem& jobSystem, It first, It last, JobPriority priority = JobPriority::Normal)
+	{
+		using T = typename std::iterator_traits<It>::value_type;
+		if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool> && std::contiguous_iterator<It>)
+		{
+			ParallelAlgorithms::RadixSort(jobSystem, std::to_address(first), static_cast<size_t>(last - first), [](T value) { return value; }, priority);
+		}
+		else
+		{
+			ParallelSort(jobSystem, first, last, std::less<>(), priority);
+		}
+	}
+
+	/// <summary>
+	/// Stable parallel radix sort of [first, last) by the integer 'keyFunc(element)' returns,
+	/// for sorting records by a packed key (render keys: material, depth).
+	/// </summary>
+	template<typename It, typename KeyFunc>
+	void ParallelSortByKey(JobSystem& jobSystem, It first, It last, KeyFunc keyFunc, JobPriority priority = JobPriority::Normal)
+	{
+		static_assert(std::contiguous_iterator<It>, "ParallelSortByKey needs contiguous memory.");
+		ParallelAlgorithms::RadixSort(jobSystem, std::to_address(first), static_cast<size_t>(last - first), keyFunc, priority);
+	}
+
+	/// <summary>
+	/// Stable partition of [first, last): elements 'pred' accepts move to the front in their order.
+	/// Returns the first element 'pred' rejects. Each block counts its matches in parallel, the prefix
+	/// sums give every block its output positions and the blocks scatter in parallel.
+	/// </summary>
+	template<typename It, typename Predicate>
+	It ParallelPartition(JobSystem& jobSystem, It first, It last, Predicate pred, JobPriority priority = JobPriority::Normal)
+	{
+		using T = typename std::iterator_traits<It>::value_type;
+		size_t const count = static_cast<size_t>(last - first);
+		if (count < ParallelAlgorithms::c_SerialThreshold)
+		{
+			return std::stable_partition(first, last, pred);
+		}
+
+		// Remember what 'pred' returned, it may be costly and is only called once per element.
+		size_t const blockCount = ParallelAlgorithms::GetBlockCount(jobSystem, count);
+		ScratchBuffer flagScratch(count + blockCount * sizeof(size_t));
+		size_t* const offsets = flagScratch.As<size_t>();
+		uint8_t* const flags = reinterpret_cast<uint8_t*>(offsets + blockCount);
+		ParallelAlgorithms::ForEachBlock(jobSystem, priority, blockCount, count, [&](size_t block, size_t begin, size_t end)
+										 {
+											 size_t matches = 0;
+											 for (size_t i = begin; i < end; ++i)
+											 {
+												 flags[i] = pred(first[i]) ? 1 : 0;
+												 matches += flags[i];
+											 }
+											 offsets[block] = matches;
+										 });
+
+		size_t totalMatches = 0;
+		for (size_t block = 0; block < blockCount; ++block)
+		{
+			size_t const matches = offsets[block];
+			offsets[block] = totalMatches;
+			totalMatches += matches;
+		}
+
+		// Copy the elements aside, then scatter them back in place.
+		auto scatter = [&](auto src)
+		{
+			ParallelAlgorithms::ForEachBlock(jobSystem, priority, blockCount, count, [&](size_t, size_t begin, size_t end)
+											 {
+												 std::move(first + begin, first + end, src + begin);
+											 });
+			ParallelAlgorithms::ForEachBlock(jobSystem, priority, blockCount, count, [&](size_t block, size_t begin, size_t end)
+											 {
+												 size_t matchOffset = offsets[block];
+												 size_t rejectOffset = totalMatches + (begin - offsets[block]);
+												 for (size_t i = begin; i < end; ++i)
+												 {
+													 first[flags[i] ? matchOffset++ : rejectOffset++] = std::move(src[i]);
+												 }
+											 });
+		};
+		if constexpr (std::is_trivially_copyable_v<T> && std::contiguous_iterator<It>)
+		{
+			ScratchBuffer scratch(count * sizeof(T));
+			scatter(scratch.As<T>());
+		}
+		else
+		{
+			std::vector<T> scratch(count);
+			scatter(scratch.begin());
+		}
+		return first + totalMatches;
+	}
+}
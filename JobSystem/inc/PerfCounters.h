@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdint.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Insight::JS
+{
+	/// <summary>
+	/// Hardware counter totals of one or more jobs.
+	/// </summary>
+	struct PerfCounterValues
+	{
+		uint64_t Jobs = 0;
+		uint64_t Cycles = 0;
+		uint64_t Instructions = 0;
+		uint64_t CacheMisses = 0;		// Last level cache misses.
+		uint64_t BranchMisses = 0;
+
+		double GetInstructionsPerCycle() const { return Cycles > 0 ? static_cast<double>(Instructions) / static_cast<double>(Cycles) : 0.0; }
+		double GetCacheMissesPerKiloInstruction() const { return Instructions > 0 ? static_cast<double>(CacheMisses) * 1000.0 / static_cast<double>(Instructions) : 0.0; }
+
+		PerfCounterValues& operator+=(PerfCounterValues const& other)
+		{
+			Jobs += other.Jobs;
+			Cycles += other.Cycles;
+			Instructions += other.Instructions;
+			CacheMisses += other.CacheMisses;
+			BranchMisses += other.BranchMisses;
+			return *this;
+		}
+	};
+
+	/// <summary>
+	/// perf_event_open counters (cycles, instructions, LLC misses, branch misses) of a single thread,
+	/// read around every job in 'IJob::Call' and summed per job name.
+	/// Only compiled in with JS_ENABLE_PERF_COUNTERS (premake option 'with-perf-counters') on Linux,
+	/// otherwise 'Open' fails and jobs run without any extra work.
+	/// </summary>
+	class PerfCounters
+	{
+	public:
+		PerfCounters() = default;
+		PerfCounters(PerfCounters const& other) = delete;
+		~PerfCounters();
+
+		// Open the counters for the calling thread.
+		bool Open();
+		bool IsOpen() const { return m_groupFd >= 0; }
+
+		// Current counter values of the thread, 'Jobs' is left at 0.
+		bool Read(PerfCounterValues& values) const;
+		// Counted for every job measured on this thread so far, taken with 'start' so the jobs nested in a job can be subtracted.
+		PerfCounterValues const& GetMeasured() const { return m_measured; }
+		void AddJob(const char* name, PerfCounterValues const& start, PerfCounterValues const& end, PerfCounterValues const& measuredAtStart);
+		void AddTo(std::map<std::string, PerfCounterValues>& totals) const;
+
+		// Counters of the calling thread, nullptr when it has none.
+		static PerfCounters* GetCurrent();
+		static void SetCurrent(PerfCounters* counters);
+
+		PerfCounters& operator=(PerfCounters const& other) = delete;
+
+	private:
+		void Close();
+
+	private:
+		static constexpr uint32_t c_NumCounters = 4;
+
+		int m_groupFd = -1;
+		int m_fds[c_NumCounters] = { -1, -1, -1, -1 };
+		// Keyed by the name pointer, job names are expected to be string literals.
+		std::unordered_map<const char*, PerfCounterValues> m_totals;
+		mutable std::mutex m_totalsMutex;
+		PerfCounterValues m_measured;		// Only used by the thread owning the counters.
+	};
+}
@@ -0,0 +1,330 @@
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "JobSystemManager.h"
+#include "LockFreeQueue.h"
+
+namespace Insight::JS
+{
+	enum class PipelineStageMode : uint8_t
+	{
+		Parallel,				// Any number of tokens at once, in any order.
+		SerialInOrder,			// One token at a time, in the order the source produced them.
+		SerialOutOfOrder,		// One token at a time, in any order.
+	};
+
+	/// <summary>
+	/// Streaming pipeline (decompress -> parse -> transform -> write) on a job system, like TBB's parallel_pipeline.
+	/// A serial source fills tokens which then flow through the stages as jobs on the workers. At most
+	/// 'maxTokensInFlight' tokens exist, which bounds memory, and they are reused: a token keeps its buffers
+	/// (vectors, strings) from one input to the next, so stages should overwrite rather than reallocate them.
+	/// A token waiting for a busy serial stage is parked, not blocking a worker, and is scheduled again by
+	/// the token leaving the stage.
+	/// </summary>
+	template<typename Token>
+	class Pipeline : public NonCopyable
+	{
+	public:
+		Pipeline(JobSystem& jobSystem, uint32_t maxTokensInFlight, JobPriority priority = JobPriority::Normal)
+			: m_jobSystem(jobSystem)
+			, m_priority(priority)
+			, m_slots(std::max<uint32_t>(maxTokensInFlight, 1))
+			, m_freeSlots(std::bit_ceil<uint32_t>(std::max<uint32_t>(maxTokensInFlight, 2)))
+		{
+			for (Slot& slot : m_slots)
+			{
+				m_freeSlots.enqueue(&slot);
+			}
+		}
+
+		// 'func(Token&)' fills the token with the next input and returns false when there is none left. Runs serially.
+		template<typename Func>
+		Pipeline& SetSource(Func func)
+		{
+			m_source = std::move(func);
+			return *this;
+		}
+
+		// 'func(Token&)' returns void, or bool where false drops the token and the later stages skip it.
+		template<typename Func>
+		Pipeline& AddStage(PipelineStageMode mode, Func func)
+		{
+			std::unique_ptr<Stage> stage = std::make_unique<Stage>();
+			stage->Mode = mode;
+			if constexpr (std::is_same_v<std::invoke_result_t<Func&, Token&>, bool>)
+			{
+				stage->Func = std::move(func);
+			}
+			else
+			{
+				stage->Func = [func = std::move(func)](Token& token) mutable
+				{
+					func(token);
+					return true;
+				};
+			}
+			m_stages.push_back(std::move(stage));
+			return *this;
+		}
+
+		/// <summary>
+		/// Run until the source has no input left and every token went through every stage, running other
+		/// pending jobs meanwhile. The first exception stops the source, the tokens in flight skip their
+		/// remaining stages and it is rethrown here. The pipeline can be run again afterwards.
+		/// </summary>
+		void Run()
+		{
+			if (!m_source)
+			{
+				throw std::invalid_argument("Pipeline has no source!");
+			}
+
+			m_inputDone.store(false, std::memory_order_relaxed);
+			m_hasException.store(false, std::memory_order_relaxed);
+			m_exception = nullptr;
+			m_nextSequence = 0;
+			for (std::unique_ptr<Stage>& stage : m_stages)
+			{
+				stage->NextSequence = 0;
+			}
+
+			RequestInput();
+			// Nothing touches the pipeline once no tokens are in flight and the source is done and idle.
+			while (m_sourceRequests.load(std::memory_order_acquire) > 0
+				|| m_tokensInFlight.load(std::memory_order_acquire) > 0
+				|| !m_inputDone.load(std::memory_order_acquire))
+			{
+				if (!JobSystemManager::RunPendingJob())
+				{
+					std::this_thread::yield();
+				}
+			}
+
+			if (m_exception)
+			{
+				std::exception_ptr exception = std::move(m_exception);
+				m_exception = nullptr;
+				std::rethrow_exception(exception);
+			}
+		}
+
+		uint32_t GetMaxTokensInFlight() const { return static_cast<uint32_t>(m_slots.size()); }
+		uint32_t GetTokensInFlight() const { return m_tokensInFlight.load(std::memory_order_acquire); }
+
+	private:
+		struct Slot
+		{
+			Token Value = Token();
+			uint64_t Sequence = 0;
+			bool Dropped = false;
+		};
+
+		struct Stage
+		{
+			PipelineStageMode Mode = PipelineStageMode::Parallel;
+			std::function<bool(Token&)> Func;
+
+			// Serial stages only.
+			std::mutex Mutex;
+			bool Busy = false;
+			uint64_t NextSequence = 0;						// SerialInOrder, the sequence allowed in next.
+			std::deque<Slot*> Waiting;						// SerialOutOfOrder.
+			std::map<uint64_t, Slot*> Parked;				// SerialInOrder, by sequence.
+		};
+
+		/// <summary>
+		/// Only one thread runs the source. A thread asking for input while it runs leaves it to that
+		/// thread, which checks for free tokens again before it stops.
+		/// </summary>
+		void RequestInput()
+		{
+			if (m_sourceRequests.fetch_add(1, std::memory_order_acq_rel) != 0)
+			{
+				return;
+			}
+			do
+			{
+				ReadInput();
+			} while (m_sourceRequests.fetch_sub(1, std::memory_order_acq_rel) != 1);
+		}
+
+		void ReadInput()
+		{
+			Slot* slot = nullptr;
+			while (!m_inputDone.load(std::memory_order_acquire) && m_freeSlots.dequeue(slot))
+			{
+				bool hasInput = false;
+				if (!m_hasException.load(std::memory_order_acquire))
+				{
+					try
+					{
+						hasInput = m_source(slot->Value);
+					}
+					catch (...)
+					{
+						SetException(std::current_exception());
+					}
+				}
+				if (!hasInput)
+				{
+					m_freeSlots.enqueue(slot);
+					m_inputDone.store(true, std::memory_order_release);
+					return;
+				}
+
+				slot->Sequence = m_nextSequence++;
+				slot->Dropped = false;
+				m_tokensInFlight.fetch_add(1, std::memory_order_acq_rel);
+				Schedule(slot, 0, false);
+			}
+		}
+
+		void Schedule(Slot* slot, size_t stageIndex, bool entered)
+		{
+			try
+			{
+				m_jobSystem.ScheduleJob(JobSystem::CreateJob(m_priority, [this, slot, stageIndex, entered]()
+															 {
+																 Process(slot, stageIndex, entered);
+															 }));
+			}
+			catch (std::overflow_error const&)
+			{
+				// The queue is full, carry on with the token on this thread.
+				Process(slot, stageIndex, entered);
+			}
+		}
+
+		// Run 'slot' through the stages from 'stageIndex'. 'entered' is true if it already holds that serial stage.
+		void Process(Slot* slot, size_t stageIndex, bool entered)
+		{
+			for (; stageIndex < m_stages.size(); ++stageIndex)
+			{
+				Stage& stage = *m_stages[stageIndex];
+				if (stage.Mode == PipelineStageMode::Parallel)
+				{
+					Call(stage, *slot);
+					continue;
+				}
+
+				if (!entered && !Enter(stage, slot))
+				{
+					// Parked, the token leaving the stage schedules it.
+					return;
+				}
+				entered = false;
+				Call(stage, *slot);
+				if (Slot* next = Leave(stage))
+				{
+					Schedule(next, stageIndex, true);
+				}
+			}
+			Finish(slot);
+		}
+
+		void Call(Stage& stage, Slot& slot)
+		{
+			if (slot.Dropped || m_hasException.load(std::memory_order_acquire))
+			{
+				return;
+			}
+			try
+			{
+				slot.Dropped = !stage.Func(slot.Value);
+			}
+			catch (...)
+			{
+				SetException(std::current_exception());
+			}
+		}
+
+		bool Enter(Stage& stage, Slot* slot)
+		{
+			std::lock_guard lock(stage.Mutex);
+			bool const inOrder = stage.Mode == PipelineStageMode::SerialInOrder;
+			if (!stage.Busy && (!inOrder || slot->Sequence == stage.NextSequence))
+			{
+				stage.Busy = true;
+				return true;
+			}
+			if (inOrder)
+			{
+				stage.Parked.emplace(slot->Sequence, slot);
+			}
+			else
+			{
+				stage.Waiting.push_back(slot);
+			}
+			return false;
+		}
+
+		// Returns the parked token which now holds the stage, if any.
+		Slot* Leave(Stage& stage)
+		{
+			std::lock_guard lock(stage.Mutex);
+			Slot* next = nullptr;
+			if (stage.Mode == PipelineStageMode::SerialInOrder)
+			{
+				++stage.NextSequence;
+				auto itr = stage.Parked.find(stage.NextSequence);
+				if (itr != stage.Parked.end())
+				{
+					next = itr->second;
+					stage.Parked.erase(itr);
+				}
+			}
+			else if (!stage.Waiting.empty())
+			{
+				next = stage.Waiting.front();
+				stage.Waiting.pop_front();
+			}
+			stage.Busy = next != nullptr;
+			return next;
+		}
+
+		void Finish(Slot* slot)
+		{
+			m_freeSlots.enqueue(slot);
+			RequestInput();
+			// Last use of the pipeline by this thread, 'Run' may return after it.
+			m_tokensInFlight.fetch_sub(1, std::memory_order_acq_rel);
+		}
+
+		void SetException(std::exception_ptr exception)
+		{
+			if (!m_hasException.exchange(true, std::memory_order_acq_rel))
+			{
+				m_exception = std::move(exception);
+			}
+		}
+
+	private:
+		JobSystem& m_jobSystem;
+		JobPriority m_priority;
+		std::function<bool(Token&)> m_source;
+		std::vector<std::unique_ptr<Stage>> m_stages;
+
+		std::vector<Slot> m_slots;
+		LockFreeQueue<Slot*> m_freeSlots;
+		uint64_t m_nextSequence = 0;						// Only the thread running the source uses it.
+
+		std::atomic<uint32_t> m_sourceRequests = 0;
+		std::atomic<uint32_t> m_tokensInFlight = 0;
+		std::atomic<bool> m_inputDone = false;
+		std::atomic<bool> m_hasException = false;
+		std::exception_ptr m_exception;					// Written once by the thread which set 'm_hasException'.
+	};
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "Job.h"
+
+namespace Insight::JS
+{
+	/// <summary>
+	/// Temporary memory for parallel algorithms, taken from a pool so sorting every frame does not go to the heap.
+	/// Freed buffers are cached per thread (like coroutine frames), a worker reuses the buffers of the jobs it ran before.
+	/// Memory is 64 byte aligned and uninitialised, only use it for trivially copyable types.
+	/// </summary>
+	class ScratchBuffer : public NonCopyable
+	{
+	public:
+		explicit ScratchBuffer(size_t bytes);
+		~ScratchBuffer();
+
+		void* GetData() const { return m_data; }
+		size_t GetSize() const { return m_size; }
+		template<typename T>
+		T* As() const { return static_cast<T*>(m_data); }
+
+		// Free the calling thread's cached buffers.
+		static void ReleaseCache();
+
+	private:
+		void* m_data = nullptr;
+		size_t m_size = 0;
+	};
+}
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+#include "JobSystemManager.h"
+
+namespace Insight::JS
+{
+	/// <summary>
+	/// Size class pool for coroutine frames. Freed frames are cached per thread so creating
+	/// a 'Task' does not go to the heap once the pool is warm.
+	/// </summary>
+	class CoroutineFrameAllocator
+	{
+	public:
+		static void* Allocate(size_t size);
+		static void Free(void* ptr, size_t size);
+	};
+
+	/// <summary>
+	/// Shared promise state for 'Task'. Holds the coroutine waiting on the task and any exception thrown.
+	/// </summary>
+	class TaskPromiseBase
+	{
+	public:
+		struct FinalAwaiter
+		{
+			bool await_ready() const noexcept { return false; }
+			template<typename Promise>
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+			{
+				// Nothing may touch the frame after Complete(), a waiter could destroy it straight away.
+				return handle.promise().Complete();
+			}
+			void await_resume() const noexcept { }
+		};
+
+		std::suspend_always initial_suspend() const noexcept { return { }; }
+		FinalAwaiter final_suspend() const noexcept { return { }; }
+		void unhandled_exception() noexcept { m_exception = std::current_exception(); }
+
+		static void* operator new(size_t size) { return CoroutineFrameAllocator::Allocate(size); }
+		static void operator delete(void* ptr, size_t size) { CoroutineFrameAllocator::Free(ptr, size); }
+
+		bool IsDone() const { return m_continuation.load(std::memory_order_acquire) == GetCompletedMarker(); }
+
+		// Returns false if the task has already completed, the caller should then continue straight away.
+		bool SetContinuation(std::coroutine_handle<> continuation)
+		{
+			void* expected = nullptr;
+			return m_continuation.compare_exchange_strong(expected, continuation.address(), std::memory_order_acq_rel, std::memory_order_acquire);
+		}
+
+		std::coroutine_handle<> Complete() noexcept
+		{
+			void* continuation = m_continuation.exchange(GetCompletedMarker(), std::memory_order_acq_rel);
+			if (continuation)
+			{
+				return std::coroutine_handle<>::from_address(continuation);
+			}
+			return std::noop_coroutine();
+		}
+
+	protected:
+		void RethrowIfFailed() const
+		{
+			if (m_exception)
+			{
+				std::rethrow_exception(m_exception);
+			}
+		}
+
+	private:
+		void* GetCompletedMarker() const { return const_cast<TaskPromiseBase*>(this); }
+
+		std::atomic<void*> m_continuation = nullptr;
+		std::exception_ptr m_exception;
+	};
+
+	template<typename ResultType>
+	class TaskPromise : public TaskPromiseBase
+	{
+	public:
+		template<typename Value>
+		void return_value(Value&& value) { m_result.emplace(std::forward<Value>(value)); }
+
+		ResultType TakeResult()
+		{
+			RethrowIfFailed();
+			return std::move(*m_result);
+		}
+
+	private:
+		std::optional<ResultType> m_result;
+	};
+
+	template<>
+	class TaskPromise<void> : public TaskPromiseBase
+	{
+	public:
+		void return_void() const { }
+		void TakeResult() const { RethrowIfFailed(); }
+	};
+
+	/// <summary>
+	/// Lazily started coroutine. Start it on a job system with 'Schedule' or by 'co_await'ing it
+	/// from another coroutine. Jobs and tasks can be 'co_await'ed inside, the coroutine is resumed
+	/// on a job system worker once they finish instead of blocking the thread.
+	/// The 'Task' owns the coroutine frame and must outlive the coroutine.
+	/// </summary>
+	template<typename ResultType = void>
+	class Task
+	{
+	public:
+		struct promise_type : public TaskPromise<ResultType>
+		{
+			Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		};
+
+		struct Awaiter
+		{
+			std::coroutine_handle<promise_type> Handle;
+			bool Started = false;
+
+			bool await_ready() const { return Handle.promise().IsDone(); }
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting)
+			{
+				if (!Handle.promise().SetContinuation(awaiting))
+				{
+					return awaiting;
+				}
+				// Not started yet, run it on this thread straight away.
+				return Started ? std::noop_coroutine() : std::coroutine_handle<>(Handle);
+			}
+			ResultType await_resume() { return Handle.promise().TakeResult(); }
+		};
+
+		Task() = default;
+		Task(Task const& other) = delete;
+		Task(Task&& other) noexcept
+			: m_handle(std::exchange(other.m_handle, nullptr))
+			, m_started(other.m_started)
+		{ }
+		~Task()
+		{
+			if (m_handle)
+			{
+				m_handle.destroy();
+			}
+		}
+
+		Task& operator=(Task const& other) = delete;
+		Task& operator=(Task&& other) noexcept
+		{
+			if (this != &other)
+			{
+				if (m_handle)
+				{
+					m_handle.destroy();
+				}
+				m_handle = std::exchange(other.m_handle, nullptr);
+				m_started = other.m_started;
+			}
+			return *this;
+		}
+
+		/// <summary>
+		/// Start the coroutine on a job system worker.
+		/// </summary>
+		void Schedule(JobSystem& jobSystem, JobPriority priority = JobPriority::Normal)
+		{
+			assert(!m_started && "[Task::Schedule] Task has already been started.");
+			m_started = true;
+			std::coroutine_handle<promise_type> handle = m_handle;
+			jobSystem.ScheduleJob(JobSystem::CreateJob(priority, [handle]()
+													   {
+														   handle.resume();
+													   }));
+		}
+
+		/// <summary>
+		/// Block until the coroutine has finished. A task which has not been started runs on the calling thread.
+		/// On a worker thread other jobs are run meanwhile, the coroutine may be waiting on one of them.
+		/// </summary>
+		void Wait()
+		{
+			if (!m_started)
+			{
+				m_started = true;
+				m_handle.resume();
+			}
+			while (!IsReady())
+			{
+				if (!JobSystemManager::RunPendingJob())
+				{
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		// Wait for the coroutine and move its result out, rethrowing any exception it threw.
+		ResultType GetResult()
+		{
+			Wait();
+			return m_handle.promise().TakeResult();
+		}
+
+		bool IsValid() const { return m_handle != nullptr; }
+		bool IsReady() const { return m_handle && m_handle.promise().IsDone(); }
+
+		Awaiter operator co_await() &
+		{
+			Awaiter awaiter{ m_handle, m_started };
+			m_started = true;
+			return awaiter;
+		}
+		Awaiter operator co_await() && { return operator co_await(); }
+
+	private:
+		explicit Task(std::coroutine_handle<promise_type> handle)
+			: m_handle(handle)
+		{ }
+
+	private:
+		std::coroutine_handle<promise_type> m_handle = nullptr;
+		bool m_started = false;
+	};
+
+	/// <summary>
+	/// Suspends until a job has finished and resumes on the job system the job ran on.
+	/// </summary>
+	template<typename JobType>
+	struct JobAwaiter
+	{
+		std::shared_ptr<JobType> Job;
+
+		bool await_ready() const { return Job->IsFinished(); }
+		void await_suspend(std::coroutine_handle<> awaiting)
+		{
+			// 'Then' schedules straight away if the job finished in the meantime.
+			// Always resume, the job's exception is rethrown from await_resume.
+			Job->Then(JobExceptionPolicy::RunAnyway, [awaiting]()
+					  {
+						  awaiting.resume();
+					  });
+		}
+		auto await_resume()
+		{
+			if constexpr (!std::is_same_v<JobType, IJob>)
+			{
+				return Job->GetResult().GetResult();
+			}
+			else if (Job->HasException())
+			{
+				std::rethrow_exception(Job->GetException());
+			}
+		}
+	};
+
+	inline JobAwaiter<IJob> operator co_await(JobSharedPtr const& job)
+	{
+		return JobAwaiter<IJob>{ job };
+	}
+
+	template<typename ResultType>
+	JobAwaiter<JobWithResult<ResultType>> operator co_await(JobWithResultSharedPtr<ResultType> const& job)
+	{
+		return JobAwaiter<JobWithResult<ResultType>>{ job };
+	}
+
+	/// <summary>
+	/// 'co_await ResumeOn(jobSystem)' continues the coroutine on one of the job system's workers.
+	/// </summary>
+	struct ResumeOnAwaiter
+	{
+		JobSystem& System;
+		JobPriority Priority;
+
+		bool await_ready() const { return false; }
+		void await_suspend(std::coroutine_handle<> awaiting)
+		{
+			System.ScheduleJob(JobSystem::CreateJob(Priority, [awaiting]()
+													{
+														awaiting.resume();
+													}));
+		}
+		void await_resume() const { }
+	};
+
+	inline ResumeOnAwaiter ResumeOn(JobSystem& jobSystem, JobPriority priority = JobPriority::Normal)
+	{
+		return ResumeOnAwaiter{ jobSystem, priority };
+	}
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <exception>
+#include "JobSystemManager.h"
+
+namespace Insight::JS
+{
+	/// <summary>
+	/// Structured fork/join: jobs run into the group from any thread are joined by one 'Wait'.
+	/// The group counts its unfinished jobs instead of holding them, so joining is one atomic
+	/// however many jobs ran, and a job can recurse with a group of its own on the stack.
+	/// The first exception thrown cancels the jobs which have not started and is rethrown by 'Wait'.
+	/// The destructor joins, call 'Wait' first to see exceptions.
+	/// </summary>
+	class TaskGroup : public NonCopyable
+	{
+	public:
+		explicit TaskGroup(JobSystem& jobSystem, JobPriority priority = JobPriority::Normal);
+		~TaskGroup();
+
+		// Schedule 'func()' as part of the group. Throws like 'JobSystem::ScheduleJob' if the queue is full.
+		template<typename Func>
+		void Run(Func func)
+		{
+			m_pendingJobs.fetch_add(1, std::memory_order_relaxed);
+			auto job = JobSystem::CreateJob(m_priority, [this, func = std::move(func)]() mutable
+											{
+												if (!IsCanceled())
+												{
+													try
+													{
+														func();
+													}
+													catch (...)
+													{
+														SetException(std::current_exception());
+													}
+												}
+												// The group may be destroyed as soon as this reaches zero, don't touch it after.
+												m_pendingJobs.fetch_sub(1, std::memory_order_acq_rel);
+											});
+			try
+			{
+				m_jobSystem.ScheduleJob(job);
+			}
+			catch (...)
+			{
+				m_pendingJobs.fetch_sub(1, std::memory_order_acq_rel);
+				throw;
+			}
+		}
+
+		/// <summary>
+		/// Wait for every job run so far, running other pending jobs meanwhile. Rethrows the first
+		/// exception and resets the group, so it can be used again.
+		/// </summary>
+		void Wait();
+		// Jobs which have not started yet are skipped, 'Wait' still joins the ones running.
+		void Cancel() { m_canceled.store(true, std::memory_order_release); }
+
+		bool IsCanceled() const { return m_canceled.load(std::memory_order_acquire); }
+		uint32_t GetPendingJobsCount() const { return m_pendingJobs.load(std::memory_order_acquire); }
+
+	private:
+		void SetException(std::exception_ptr exception);
+		void Join();
+
+	private:
+		JobSystem& m_jobSystem;
+		JobPriority m_priority;
+		std::atomic<uint32_t> m_pendingJobs = 0;
+		std::atomic<bool> m_canceled = false;
+		std::atomic<bool> m_hasException = false;
+		std::exception_ptr m_exception;			// Written once by the job which set 'm_hasException'.
+	};
+}
@@ -1,7 +1,12 @@
 #pragma once
 
 #include "TLS.h"
+#include "ThreadStats.h"
+#include "Trace.h"
+#include "LatencyHistogram.h"
+#include "PerfCounters.h"
 #include <thread>
+#include <atomic>
 #include <mutex>
 
 namespace Insight::JS
@@ -14,6 +19,7 @@ namespace Insight::JS
 	{
 		JobSystemManager* Manager = nullptr;
 		JobSystem* System = nullptr;
+		JobSystem* LentSystem = nullptr;	// Elastic job system this thread is currently lent to (serviced before 'System').
 	};
 
 	/// <summary>
@@ -31,13 +37,31 @@ namespace Insight::JS
 		// Spawns Thread with given Callback & Userdata
 		bool Spawn(Callback callback);
 		void SetThreadData(JobSystemManager* manager, JobSystem* system);
+		void SetLentSystem(JobSystem* system);
+		// 'GetUserdata', with its job systems kept alive until 'LeaveUserdata', see 'JobSystemManager::ReleaseJobSystem'.
+		ThreadData EnterUserdata();
+		void LeaveUserdata();
+		// Wait until the thread is done with user data it entered before the call. Not from the thread itself.
+		void WaitForUserdataUsers() const;
 		void SetAffinity(size_t i);
+		// Record trace events into a ring of 'capacity' events. Call before 'Spawn'.
+		void EnableTracing(uint32_t capacity);
+		// Record job latencies per priority. Call before 'Spawn'.
+		void EnableLatencyHistograms();
 
 		// Waits for Thread
 		void Join();
 
 		// Getter
 		inline TLS* GetTLS() { return &m_tls; };
+		inline ThreadStats& GetStats() { return m_stats; };
+		inline ThreadStats const& GetStats() const { return m_stats; };
+		inline TraceBuffer* GetTraceBuffer() const { return m_traceBuffer.get(); };
+		inline JobLatencyHistograms* GetLatencyHistograms() const { return m_latencyHistograms.get(); };
+#if defined(JS_ENABLE_PERF_COUNTERS)
+		inline PerfCounters& GetPerfCounters() { return m_perfCounters; };
+		inline PerfCounters const& GetPerfCounters() const { return m_perfCounters; };
+#endif
 		inline Callback GetCallback() const { return m_callback; };
 		ThreadData GetUserdata();
 		inline bool HasSpawned() const { return m_id != std::thread::id(); };
@@ -45,6 +69,8 @@ namespace Insight::JS
 
 		// Static Methods
 		static void SleepFor(uint32_t ms);
+		// Thread object of the calling thread, nullptr if it was not spawned by 'Spawn'.
+		static Thread* GetCurrent();
 
 	private:
 		Thread(std::thread handle, std::thread::id id)
@@ -55,9 +81,36 @@ namespace Insight::JS
 		std::thread m_handle;
 		std::thread::id m_id;
 		TLS m_tls;
+		ThreadStats m_stats;
+		std::unique_ptr<TraceBuffer> m_traceBuffer;
+		std::unique_ptr<JobLatencyHistograms> m_latencyHistograms;
+#if defined(JS_ENABLE_PERF_COUNTERS)
+		PerfCounters m_perfCounters;		// Opened by the thread itself.
+#endif
 
 		Callback m_callback = nullptr;
 		ThreadData m_userData;
 		std::mutex m_userDataMutex;
+		uint32_t m_userdataDepth = 0;					// Nested 'EnterUserdata' calls (RunPendingJob inside a job), only used by the thread.
+		std::atomic<uint64_t> m_userdataEpoch = 0;		// Odd while the thread is in 'EnterUserdata', bumped on the outermost enter and leave.
+	};
+
+	/// <summary>
+	/// A thread's user data for the scope, see 'Thread::EnterUserdata'.
+	/// </summary>
+	class UserdataScope
+	{
+	public:
+		explicit UserdataScope(Thread& thread) : m_thread(thread), m_data(thread.EnterUserdata()) { }
+		UserdataScope(UserdataScope const& other) = delete;
+		~UserdataScope() { m_thread.LeaveUserdata(); }
+
+		ThreadData const& Get() const { return m_data; }
+
+		UserdataScope& operator=(UserdataScope const& other) = delete;
+
+	private:
+		Thread& m_thread;
+		ThreadData m_data;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+namespace Insight::JS
+{
+	/// <summary>
+	/// Copy of a worker's counters at one point in time. Times are in nanoseconds.
+	/// </summary>
+	struct ThreadStatsSnapshot
+	{
+		uint64_t JobsExecuted = 0;
+		uint64_t StealsAttempted = 0;		// Dequeue attempts on a job system this thread was lent to.
+		uint64_t StealsSucceeded = 0;		// Jobs taken from a job system this thread was lent to.
+		uint64_t ParkCount = 0;				// Times the thread slept because it found no work.
+		uint64_t QueueFullEvents = 0;		// ScheduleJob calls from this thread which found the queue full.
+		uint64_t DeadlineJobsExecuted = 0;
+		uint64_t DeadlineMisses = 0;		// Jobs with a deadline which finished after it.
+		uint64_t IdleTimeNs = 0;
+		uint64_t TimeInJobNs = 0;
+
+		ThreadStatsSnapshot& operator+=(ThreadStatsSnapshot const& other)
+		{
+			JobsExecuted += other.JobsExecuted;
+			StealsAttempted += other.StealsAttempted;
+			StealsSucceeded += other.StealsSucceeded;
+			ParkCount += other.ParkCount;
+			QueueFullEvents += other.QueueFullEvents;
+			DeadlineJobsExecuted += other.DeadlineJobsExecuted;
+			DeadlineMisses += other.DeadlineMisses;
+			IdleTimeNs += other.IdleTimeNs;
+			TimeInJobNs += other.TimeInJobNs;
+			return *this;
+		}
+	};
+
+	/// <summary>
+	/// Counters owned by a single worker thread. Only the owning thread writes them (no read-modify-write
+	/// atomics needed) and the struct fills whole cache lines so workers never share a line.
+	/// Any thread can read them with 'GetSnapshot' while the worker runs.
+	/// </summary>
+	struct alignas(64) ThreadStats
+	{
+		std::atomic<uint64_t> JobsExecuted = 0;
+		std::atomic<uint64_t> StealsAttempted = 0;
+		std::atomic<uint64_t> StealsSucceeded = 0;
+		std::atomic<uint64_t> ParkCount = 0;
+		std::atomic<uint64_t> QueueFullEvents = 0;
+		std::atomic<uint64_t> DeadlineJobsExecuted = 0;
+		std::atomic<uint64_t> DeadlineMisses = 0;
+		std::atomic<uint64_t> IdleTimeNs = 0;
+		std::atomic<uint64_t> TimeInJobNs = 0;
+
+		// Only call from the owning thread.
+		static void Add(std::atomic<uint64_t>& counter, uint64_t value)
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+
+		ThreadStatsSnapshot GetSnapshot() const
+		{
+			ThreadStatsSnapshot snapshot;
+			snapshot.JobsExecuted = JobsExecuted.load(std::memory_order_relaxed);
+			snapshot.StealsAttempted = StealsAttempted.load(std::memory_order_relaxed);
+			snapshot.StealsSucceeded = StealsSucceeded.load(std::memory_order_relaxed);
+			snapshot.ParkCount = ParkCount.load(std::memory_order_relaxed);
+			snapshot.QueueFullEvents = QueueFullEvents.load(std::memory_order_relaxed);
+			snapshot.DeadlineJobsExecuted = DeadlineJobsExecuted.load(std::memory_order_relaxed);
+			snapshot.DeadlineMisses = DeadlineMisses.load(std::memory_order_relaxed);
+			snapshot.IdleTimeNs = IdleTimeNs.load(std::memory_order_relaxed);
+			snapshot.TimeInJobNs = TimeInJobNs.load(std::memory_order_relaxed);
+			return snapshot;
+		}
+	};
+}
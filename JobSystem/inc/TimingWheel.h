@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "Job.h"
+
+namespace Insight::JS
+{
+	class TimingWheel;
+
+	/// <summary>
+	/// Identifies a pending timer for 'CancelTimer'. Stays safe to use after the timer fired or was cancelled.
+	/// </summary>
+	struct TimerHandle
+	{
+		TimingWheel* Wheel = nullptr;
+		uint32_t Index = UINT32_MAX;
+		uint32_t Generation = 0;
+
+		bool IsValid() const { return Wheel != nullptr; }
+	};
+
+	/// <summary>
+	/// Hierarchical timing wheel of jobs waiting for a point in time (Varghese & Lauck, as in the Linux kernel).
+	/// 4 levels of 256 slots with a 1ms tick cover 49 days, later timers are re-inserted until they are in range.
+	/// Insert and cancel are O(1), entries live in a pool linked by index so pending timers don't allocate.
+	/// Advancing only needs a try_lock, so any idle worker can service the wheel without waiting on another.
+	/// </summary>
+	class TimingWheel
+	{
+	public:
+		TimingWheel();
+		TimingWheel(TimingWheel const& other) = delete;
+
+		// Times are steady_clock nanoseconds.
+		TimerHandle Add(JobSharedPtr const& job, uint64_t expiryNs);
+		// Returns the job if the timer was still pending, nullptr if it fired or was cancelled already.
+		JobSharedPtr Cancel(TimerHandle const& handle);
+		// Remove every pending timer and append their jobs to 'jobs'.
+		void Clear(std::vector<JobSharedPtr>& jobs);
+
+		/// <summary>
+		/// Move the wheel to 'nowNs' and append expired jobs to 'expired'.
+		/// Returns false without waiting if another thread is advancing the wheel.
+		/// </summary>
+		bool TryAdvance(uint64_t nowNs, std::vector<JobSharedPtr>& expired);
+
+		uint32_t GetPendingCount() const { return m_pendingCount.load(std::memory_order_acquire); }
+
+		TimingWheel& operator=(TimingWheel const& other) = delete;
+
+	private:
+		static constexpr uint32_t c_Levels = 4;
+		static constexpr uint32_t c_SlotBits = 8;
+		static constexpr uint32_t c_Slots = 1u << c_SlotBits;
+		static constexpr uint32_t c_SlotMask = c_Slots - 1;
+		static constexpr uint32_t c_None = UINT32_MAX;
+		static constexpr uint64_t c_TickNs = 1000000;
+
+		struct Entry
+		{
+			JobSharedPtr Job;
+			uint64_t ExpiryTick = 0;
+			uint32_t Prev = c_None;
+			uint32_t Next = c_None;
+			uint32_t Slot = c_None;		// level * c_Slots + slot, c_None when the entry is free.
+			uint32_t Generation = 0;
+		};
+
+		uint64_t ToTick(uint64_t ns) const;
+		void Link(uint32_t index);
+		void Unlink(uint32_t index);
+		void Free(uint32_t index);
+		void Cascade(uint32_t level);
+
+	private:
+		std::mutex m_mutex;
+		std::vector<Entry> m_entries;
+		std::vector<uint32_t> m_freeEntries;
+		std::array<uint32_t, c_Levels * c_Slots> m_slots;	// Head entry of each slot's list.
+		uint64_t m_startNs = 0;
+		uint64_t m_currentTick = 0;							// Next tick to expire.
+		std::atomic<uint32_t> m_pendingCount = 0;
+	};
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace Insight::JS
+{
+	// Every '...End' directly follows its '...Begin'.
+	enum class TraceEventType : uint8_t
+	{
+		JobBegin,
+		JobEnd,
+		WaitBegin,		// Thread is blocked in IJob::Wait, JobWaitList::Wait or TaskGroup::Wait.
+		WaitEnd,
+		ParkBegin,		// Worker found no work and sleeps.
+		ParkEnd,
+		Steal,			// Worker took a job from the job system it was lent to.
+	};
+
+	struct TraceEvent
+	{
+		uint64_t Timestamp = 0;			// TraceClock ticks.
+		const char* Name = nullptr;		// Job name, must outlive the trace (string literal).
+		TraceEventType Type = TraceEventType::JobBegin;
+	};
+
+	/// <summary>
+	/// Cheapest timestamp available. The time stamp counter on x86, steady_clock nanoseconds otherwise.
+	/// Ticks are converted to time when the trace is written, see 'TraceClockCalibration'.
+	/// </summary>
+	struct TraceClock
+	{
+		static uint64_t Now();
+		static uint64_t NowNanoseconds();
+	};
+
+	/// <summary>
+	/// A TraceClock tick and a steady_clock time taken together. Two of these give the tick rate.
+	/// </summary>
+	struct TraceClockCalibration
+	{
+		uint64_t Ticks = 0;
+		uint64_t Nanoseconds = 0;
+
+		static TraceClockCalibration Capture();
+	};
+
+	/// <summary>
+	/// Fixed size ring of trace events written by a single thread. When full the oldest events are
+	/// overwritten. Recording never locks or allocates. 'Read' can be called from any thread while
+	/// the owner keeps recording, events overwritten during the copy are dropped.
+	/// </summary>
+	class TraceBuffer
+	{
+	public:
+		// 'capacity' is rounded up to a power of two.
+		explicit TraceBuffer(uint32_t capacity);
+
+		void Record(TraceEventType type, const char* name = nullptr)
+		{
+			uint64_t const index = m_writeIndex.load(std::memory_order_relaxed);
+			TraceEvent& event = m_events[index & m_mask];
+			event.Timestamp = TraceClock::Now();
+			event.Name = name;
+			event.Type = type;
+			m_writeIndex.store(index + 1, std::memory_order_release);
+		}
+
+		// Append the events still in the buffer to 'events', oldest first.
+		void Read(std::vector<TraceEvent>& events) const;
+
+		// Trace buffer of the calling thread, nullptr when it is not traced.
+		static TraceBuffer* GetCurrent();
+		static void SetCurrent(TraceBuffer* buffer);
+
+	private:
+		std::unique_ptr<TraceEvent[]> m_events;
+		uint64_t m_mask = 0;
+		std::atomic<uint64_t> m_writeIndex = 0;
+	};
+
+	struct TraceThread
+	{
+		std::string Name;
+		std::vector<TraceEvent> Events;
+	};
+
+	/// <summary>
+	/// Write threads' events as Chrome Trace Event JSON, which chrome://tracing and ui.perfetto.dev open.
+	/// Timestamps are microseconds since 'start'.
+	/// </summary>
+	void WriteChromeTrace(std::ostream& stream, std::vector<TraceThread> const& threads, TraceClockCalibration const& start);
+}
@@ -1,7 +1,7 @@
 project "JobSystem"
     kind "StaticLib"
     language "C++"
-    cppdialect "C++17"
+    cppdialect "C++20"
 	staticruntime "on"
 
     targetdir ("../bin/" .. outputdir .. "/%{prj.name}")
@@ -0,0 +1,455 @@
+#include "AsyncIO.h"
+#include "JobSystemManager.h"
+#include <fstream>
+#include <algorithm>
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define JS_ASYNC_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Insight::JS
+{
+	// Largest single read submitted to the ring, bigger reads are split.
+	static constexpr uint64_t c_MaxReadChunk = 1ull << 30;
+	// io_uring_enter calls tried for one submission before it fails, EINTR/EAGAIN/EBUSY are retried.
+	static constexpr uint32_t c_MaxSubmitAttempts = 1024;
+
+	static Buffer ReadFileBlocking(std::string const& path, uint64_t offset, uint64_t size)
+	{
+		Buffer buffer;
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+		{
+			buffer.Error = ENOENT;
+			return buffer;
+		}
+
+		uint64_t const fileSize = static_cast<uint64_t>(file.tellg());
+		if (offset >= fileSize)
+		{
+			return buffer;
+		}
+		if (size == 0 || offset + size > fileSize)
+		{
+			size = fileSize - offset;
+		}
+
+		buffer.Data.resize(size);
+		file.seekg(static_cast<std::streamoff>(offset));
+		if (!file.read(reinterpret_cast<char*>(buffer.Data.data()), static_cast<std::streamsize>(size)))
+		{
+			buffer.Data.resize(static_cast<size_t>(file.gcount()));
+			buffer.Error = EIO;
+		}
+		return buffer;
+	}
+
+	AsyncIO::~AsyncIO()
+	{
+		Release();
+	}
+
+	bool AsyncIO::Init(uint32_t queueDepth)
+	{
+		if (queueDepth == 0 || m_ringFd >= 0)
+		{
+			return IsAsync();
+		}
+
+		if (!SetupRing(queueDepth))
+		{
+			std::cout << "[AsyncIO::Init] io_uring is not available, file reads will use the blocking thread pool." << '\n';
+			return false;
+		}
+
+		m_stopping.store(false, std::memory_order_release);
+		m_reaperThread = std::thread(&AsyncIO::ReaperLoop, this);
+		return true;
+	}
+
+	JobWithResultSharedPtr<Buffer> AsyncIO::ReadFile(JobSystem& jobSystem, std::string const& path, uint64_t offset, uint64_t size, JobPriority priority)
+	{
+		if (!IsAsync())
+		{
+			JobWithResultSharedPtr<Buffer> job = JobSystem::CreateJob(priority, [path, offset, size]()
+																	  {
+																		  return ReadFileBlocking(path, offset, size);
+																	  });
+			jobSystem.ScheduleBlocking(job);
+			return job;
+		}
+
+		// The job only hands the buffer over, it is scheduled once the read has completed.
+		std::shared_ptr<ReadRequest> request = std::make_shared<ReadRequest>();
+		JobWithResultSharedPtr<Buffer> job = JobSystem::CreateJob(priority, [request]()
+																  {
+																	  return std::move(request->Result);
+																  });
+		request->Offset = offset;
+		request->Job = job;
+		request->System = &jobSystem;
+
+#ifdef JS_ASYNC_IO_URING
+		request->Fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (request->Fd < 0)
+		{
+			request->Result.Error = errno;
+			Complete(request.get());
+			return job;
+		}
+
+		if (size == 0)
+		{
+			struct stat fileStat;
+			if (fstat(request->Fd, &fileStat) == 0 && static_cast<uint64_t>(fileStat.st_size) > offset)
+			{
+				size = static_cast<uint64_t>(fileStat.st_size) - offset;
+			}
+		}
+#endif
+
+		request->Result.Data.resize(size);
+		if (size == 0)
+		{
+			Complete(request.get());
+			return job;
+		}
+
+		// The ring holds a raw pointer while the read is in flight, the job keeps the request alive.
+		Submit(request.get());
+		return job;
+	}
+
+	void AsyncIO::Complete(ReadRequest* request)
+	{
+#ifdef JS_ASYNC_IO_URING
+		if (request->Fd >= 0)
+		{
+			close(request->Fd);
+			request->Fd = -1;
+		}
+#endif
+		request->Result.Data.resize(request->BytesRead);
+
+		// Moving the job out breaks the request <-> job reference cycle.
+		JobSharedPtr job = std::move(request->Job);
+		request->System->ScheduleJob(job);
+	}
+
+	void AsyncIO::Submit(ReadRequest* request)
+	{
+		{
+			std::lock_guard lock(m_submitMutex);
+			// Never have more reads in flight than the completion queue can hold.
+			if (!m_failed.load(std::memory_order_relaxed) && m_inFlightRequests.size() >= m_cqEntries)
+			{
+				m_pendingRequests.push_back(request);
+				return;
+			}
+			if (!m_failed.load(std::memory_order_relaxed) && PushSubmission(request, 0))
+			{
+				m_inFlightRequests.push_back(request);
+				return;
+			}
+		}
+		request->Result.Error = EIO;
+		Complete(request);
+	}
+
+#ifdef JS_ASYNC_IO_URING
+	static int IOUringSetup(uint32_t entries, io_uring_params* params)
+	{
+		return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+	}
+
+	static int IOUringEnter(int ringFd, uint32_t toSubmit, uint32_t minComplete, uint32_t flags)
+	{
+		return static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+	}
+
+	static uint32_t* RingField(void* ring, uint32_t offset)
+	{
+		return reinterpret_cast<uint32_t*>(static_cast<uint8_t*>(ring) + offset);
+	}
+
+	bool AsyncIO::SetupRing(uint32_t queueDepth)
+	{
+		io_uring_params params;
+		std::memset(&params, 0, sizeof(params));
+		int ringFd = IOUringSetup(queueDepth, &params);
+		if (ringFd < 0)
+		{
+			return false;
+		}
+
+		m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+		m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		bool const singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (singleMap)
+		{
+			m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+		}
+
+		m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+		if (m_sqRing == MAP_FAILED)
+		{
+			m_sqRing = nullptr;
+			close(ringFd);
+			return false;
+		}
+		m_cqRing = singleMap ? m_sqRing : mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+		m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+		m_sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+		if (m_cqRing == MAP_FAILED || m_sqes == MAP_FAILED)
+		{
+			m_cqRing = m_cqRing == MAP_FAILED ? nullptr : m_cqRing;
+			m_sqes = m_sqes == MAP_FAILED ? nullptr : m_sqes;
+			m_ringFd = ringFd;
+			Release();
+			return false;
+		}
+
+		m_sqHead = RingField(m_sqRing, params.sq_off.head);
+		m_sqTail = RingField(m_sqRing, params.sq_off.tail);
+		m_sqMask = RingField(m_sqRing, params.sq_off.ring_mask);
+		m_sqArray = RingField(m_sqRing, params.sq_off.array);
+		m_sqEntries = params.sq_entries;
+
+		m_cqHead = RingField(m_cqRing, params.cq_off.head);
+		m_cqTail = RingField(m_cqRing, params.cq_off.tail);
+		m_cqMask = RingField(m_cqRing, params.cq_off.ring_mask);
+		m_cqes = static_cast<uint8_t*>(m_cqRing) + params.cq_off.cqes;
+		m_cqEntries = params.cq_entries;
+
+		m_ringFd = ringFd;
+		return true;
+	}
+
+	bool AsyncIO::PushSubmission(ReadRequest* request, uint8_t opcode)
+	{
+		// Called with 'm_submitMutex' held. Every submission is handed to the kernel straight away
+		// so the submission queue never fills up.
+		uint32_t const tail = *m_sqTail;
+		uint32_t const index = tail & *m_sqMask;
+		io_uring_sqe* sqe = static_cast<io_uring_sqe*>(m_sqes) + index;
+		std::memset(sqe, 0, sizeof(io_uring_sqe));
+
+		if (request)
+		{
+			uint64_t const remaining = request->Result.Data.size() - request->BytesRead;
+			sqe->opcode = IORING_OP_READ;
+			sqe->fd = request->Fd;
+			sqe->off = request->Offset + request->BytesRead;
+			sqe->addr = reinterpret_cast<uint64_t>(request->Result.Data.data() + request->BytesRead);
+			sqe->len = static_cast<uint32_t>(std::min(remaining, c_MaxReadChunk));
+			sqe->user_data = reinterpret_cast<uint64_t>(request);
+		}
+		else
+		{
+			sqe->opcode = opcode;
+			sqe->user_data = 0;
+		}
+
+		m_sqArray[index] = index;
+		__atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+		for (uint32_t attempt = 0; attempt < c_MaxSubmitAttempts; ++attempt)
+		{
+			int const submitted = IOUringEnter(m_ringFd, 1, 0, 0);
+			if (submitted == 1)
+			{
+				return true;
+			}
+			// Interrupted, or out of resources until the reaper drains completions.
+			if (submitted >= 0 || (errno != EINTR && errno != EAGAIN && errno != EBUSY))
+			{
+				break;
+			}
+			if (errno != EINTR)
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		// Not submitted. Only this thread submits and every earlier entry was consumed, so if the kernel's head
+		// hasn't reached the entry it never saw it: take it back before any later submit can hand it over.
+		// Otherwise it was consumed after all and its completion will arrive.
+		if (__atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE) == tail)
+		{
+			__atomic_store_n(m_sqTail, tail, __ATOMIC_RELEASE);
+			return false;
+		}
+		return true;
+	}
+
+	void AsyncIO::ReaperLoop()
+	{
+		while (true)
+		{
+			int const result = IOUringEnter(m_ringFd, 0, 1, IORING_ENTER_GETEVENTS);
+			if (result < 0 && errno != EINTR)
+			{
+				int const error = errno;
+				std::cout << "[AsyncIO::ReaperLoop] io_uring_enter failed: " << std::strerror(error) << ", file reads will use the blocking thread pool." << '\n';
+				FailRequests(error);
+				break;
+			}
+
+			uint32_t head = *m_cqHead;
+			uint32_t const tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+			std::vector<ReadRequest*> completed;
+			for (; head != tail; ++head)
+			{
+				io_uring_cqe const* cqe = static_cast<io_uring_cqe*>(m_cqes) + (head & *m_cqMask);
+				ReadRequest* request = reinterpret_cast<ReadRequest*>(cqe->user_data);
+				if (!request)
+				{
+					// Wake up from Release().
+					continue;
+				}
+
+				if (cqe->res < 0)
+				{
+					request->Result.Error = -cqe->res;
+				}
+				else
+				{
+					request->EndOfFile = cqe->res == 0;
+					request->BytesRead += static_cast<uint64_t>(cqe->res);
+				}
+				completed.push_back(request);
+			}
+			__atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+
+			for (ReadRequest* request : completed)
+			{
+				{
+					std::lock_guard lock(m_submitMutex);
+					auto itr = std::find(m_inFlightRequests.begin(), m_inFlightRequests.end(), request);
+					if (itr != m_inFlightRequests.end())
+					{
+						*itr = m_inFlightRequests.back();
+						m_inFlightRequests.pop_back();
+					}
+				}
+
+				// Short reads are resubmitted until the buffer is full or the end of the file is reached.
+				if (request->Result.Error == 0 && !request->EndOfFile && request->BytesRead < request->Result.Data.size())
+				{
+					Submit(request);
+				}
+				else
+				{
+					Complete(request);
+				}
+			}
+
+			std::vector<ReadRequest*> failed;
+			{
+				std::lock_guard lock(m_submitMutex);
+				while (!m_pendingRequests.empty() && m_inFlightRequests.size() < m_cqEntries)
+				{
+					ReadRequest* request = m_pendingRequests.front();
+					m_pendingRequests.pop_front();
+					if (PushSubmission(request, 0))
+					{
+						m_inFlightRequests.push_back(request);
+					}
+					else
+					{
+						failed.push_back(request);
+					}
+				}
+			}
+			for (ReadRequest* request : failed)
+			{
+				request->Result.Error = EIO;
+				Complete(request);
+			}
+
+			std::lock_guard lock(m_submitMutex);
+			if (m_stopping.load(std::memory_order_acquire) && m_inFlightRequests.empty() && m_pendingRequests.empty())
+			{
+				break;
+			}
+		}
+	}
+
+	void AsyncIO::FailRequests(int error)
+	{
+		// Setting 'm_failed' under the lock means any later Submit fails its request itself instead of queueing it.
+		std::vector<ReadRequest*> failed;
+		{
+			std::lock_guard lock(m_submitMutex);
+			m_failed.store(true, std::memory_order_release);
+			failed.swap(m_inFlightRequests);
+			failed.insert(failed.end(), m_pendingRequests.begin(), m_pendingRequests.end());
+			m_pendingRequests.clear();
+		}
+		for (ReadRequest* request : failed)
+		{
+			request->Result.Error = error;
+			Complete(request);
+		}
+	}
+
+	void AsyncIO::Release()
+	{
+		if (m_ringFd < 0)
+		{
+			return;
+		}
+
+		if (m_reaperThread.joinable())
+		{
+			m_stopping.store(true, std::memory_order_release);
+			{
+				std::lock_guard lock(m_submitMutex);
+				PushSubmission(nullptr, IORING_OP_NOP);
+			}
+			m_reaperThread.join();
+		}
+
+		if (m_sqes)
+		{
+			munmap(m_sqes, m_sqesSize);
+		}
+		if (m_cqRing && m_cqRing != m_sqRing)
+		{
+			munmap(m_cqRing, m_cqRingSize);
+		}
+		if (m_sqRing)
+		{
+			munmap(m_sqRing, m_sqRingSize);
+		}
+		m_sqes = m_cqRing = m_sqRing = nullptr;
+		close(m_ringFd);
+		m_ringFd = -1;
+	}
+#else
+	bool AsyncIO::SetupRing([[maybe_unused]] uint32_t queueDepth)
+	{
+		return false;
+	}
+
+	bool AsyncIO::PushSubmission([[maybe_unused]] ReadRequest* request, [[maybe_unused]] uint8_t opcode)
+	{
+		return false;
+	}
+
+	void AsyncIO::ReaperLoop()
+	{ }
+
+	void AsyncIO::Release()
+	{ }
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include "DeadlineQueue.h"
+#include <algorithm>
+
+namespace Insight::JS
+{
+	// std::push_heap builds a max-heap, so compare with > for the earliest deadline on top.
+	static bool LaterDeadline(JobSharedPtr const& a, JobSharedPtr const& b)
+	{
+		return a->GetDeadline() > b->GetDeadline();
+	}
+
+	DeadlineQueue::DeadlineQueue(uint32_t numShards)
+		: m_shards(std::make_unique<Shard[]>(std::clamp<uint32_t>(numShards, 1, 64)))
+		, m_numShards(std::clamp<uint32_t>(numShards, 1, 64))
+	{ }
+
+	void DeadlineQueue::Enqueue(JobSharedPtr const& job, uint32_t shardHint)
+	{
+		Shard& shard = m_shards[shardHint % m_numShards];
+		{
+			std::lock_guard lock(shard.Mutex);
+			shard.Heap.push_back(job);
+			std::push_heap(shard.Heap.begin(), shard.Heap.end(), LaterDeadline);
+			shard.EarliestDeadline.store(shard.Heap.front()->GetDeadline(), std::memory_order_release);
+		}
+		m_size.fetch_add(1, std::memory_order_release);
+	}
+
+	bool DeadlineQueue::Dequeue(JobSharedPtr& job)
+	{
+		if (size() == 0)
+		{
+			return false;
+		}
+
+		// Shards already tried this call, either empty or locked by another worker.
+		uint64_t triedShards = 0;
+		for (uint32_t attempt = 0; attempt < m_numShards; ++attempt)
+		{
+			uint32_t best = m_numShards;
+			uint64_t bestDeadline = UINT64_MAX;
+			for (uint32_t i = 0; i < m_numShards; ++i)
+			{
+				uint64_t const deadline = m_shards[i].EarliestDeadline.load(std::memory_order_acquire);
+				if ((triedShards & (1ull << i)) == 0 && deadline < bestDeadline)
+				{
+					best = i;
+					bestDeadline = deadline;
+				}
+			}
+			if (best == m_numShards)
+			{
+				return false;
+			}
+
+			triedShards |= 1ull << best;
+			Shard& shard = m_shards[best];
+			std::unique_lock lock(shard.Mutex, std::try_to_lock);
+			if (!lock.owns_lock() || shard.Heap.empty())
+			{
+				continue;
+			}
+
+			std::pop_heap(shard.Heap.begin(), shard.Heap.end(), LaterDeadline);
+			job = std::move(shard.Heap.back());
+			shard.Heap.pop_back();
+			shard.EarliestDeadline.store(shard.Heap.empty() ? UINT64_MAX : shard.Heap.front()->GetDeadline(), std::memory_order_release);
+			m_size.fetch_sub(1, std::memory_order_release);
+			return true;
+		}
+		return false;
+	}
+
+	uint64_t DeadlineQueue::GetEarliestDeadline() const
+	{
+		uint64_t earliest = UINT64_MAX;
+		for (uint32_t i = 0; i < m_numShards; ++i)
+		{
+			earliest = std::min(earliest, m_shards[i].EarliestDeadline.load(std::memory_order_acquire));
+		}
+		return earliest;
+	}
+}
@@ -1,5 +1,6 @@
 #include "Job.h"
 #include "JobSystemManager.h"
+#include "PerfCounters.h"
 
 namespace Insight::JS
 {
@@ -28,11 +29,102 @@ namespace Insight::JS
 		m_funcWrapper.reset();
 	}
 
+	uint64_t IJob::GetRecurringRuns() const
+	{
+		return m_recurrence ? m_recurrence->Runs.load(std::memory_order_relaxed) : 0;
+	}
+
+	uint64_t IJob::GetMissedPeriods() const
+	{
+		return m_recurrence ? m_recurrence->MissedPeriods.load(std::memory_order_relaxed) : 0;
+	}
+
 	void IJob::Call()
 	{
 		//std::lock_guard<std::mutex> lock(m_mutex);
 		m_state.store(JobState::Running);
-		m_funcWrapper->Call();
+#if defined(JS_ENABLE_PERF_COUNTERS)
+		PerfCounters* perfCounters = PerfCounters::GetCurrent();
+		PerfCounterValues start;
+		bool const measure = perfCounters && perfCounters->Read(start);
+		PerfCounterValues const measuredAtStart = measure ? perfCounters->GetMeasured() : PerfCounterValues();
+#endif
+		if (m_exception)
+		{
+			// Left over from the previous run of a recurring job.
+			SetException(nullptr);
+		}
+		try
+		{
+			m_funcWrapper->Call();
+		}
+		catch (...)
+		{
+			// Keep the worker alive, waiters rethrow the exception from Wait and GetResult.
+			SetException(std::current_exception());
+		}
+#if defined(JS_ENABLE_PERF_COUNTERS)
+		PerfCounterValues end;
+		if (measure && perfCounters->Read(end))
+		{
+			perfCounters->AddJob(m_name, start, end, measuredAtStart);
+		}
+#endif
+	}
+
+	void IJob::AddChild(JobSharedPtr const& job)
+	{
+		{
+			std::lock_guard lock(m_childrenMutex);
+			// A job skipped because of its parent's exception is canceled, children added later are handled straight away too.
+			if (!IsFinished() && !IsCancled())
+			{
+				m_childrenJobs.push_back(job);
+				return;
+			}
+		}
+		// This job has already finished (async jobs can finish before 'Then' is called), schedule straight away.
+		if (job->OnParentFinished(IsCancled() && !m_exception))
+		{
+			ScheduleChild(job);
+		}
+	}
+
+	bool IJob::OnParentFinished(bool noValue)
+	{
+		// WhenAny waits for a parent with a result, unless no parent is left to give one.
+		if (m_unfinishedParents.load(std::memory_order_acquire) > 0
+			&& m_unfinishedParents.fetch_sub(1, std::memory_order_acq_rel) > 1
+			&& noValue)
+		{
+			return false;
+		}
+		// Only the parent taking the count to zero schedules the job, parents finishing after that (WhenAny) don't.
+		uint32_t pending = m_pendingParents.load(std::memory_order_acquire);
+		while (pending != 0 && !m_pendingParents.compare_exchange_weak(pending, pending - 1, std::memory_order_acq_rel, std::memory_order_acquire))
+		{ }
+		return pending == 1;
+	}
+
+	void IJob::ScheduleChild(JobSharedPtr const& job)
+	{
+		if (m_exception && job->m_exceptionPolicy == JobExceptionPolicy::CancelOnParentException)
+		{
+			job->m_jobSystem = m_jobSystem;
+			job->SetException(m_exception);
+			m_jobSystem->m_queue.CompleteJob(job, JobState::Canceled);
+			return;
+		}
+		m_jobSystem->ScheduleJob(m_priority, job, false);
+	}
+
+	void IJob::SetException(std::exception_ptr exception)
+	{
+		m_exception = exception;
+		if (m_funcWrapper)
+		{
+			m_funcWrapper->SetException(std::move(exception));
+		}
 	}
 
 	void IJob::ReleaseLock()
@@ -45,8 +137,43 @@ namespace Insight::JS
 	{
 		//std::unique_lock<std::mutex> lock(m_mutex);
 		//m_conditionVariable.wait(lock);
+		TraceBuffer* trace = TraceBuffer::GetCurrent();
+		if (trace)
+		{
+			trace->Record(TraceEventType::WaitBegin);
+		}
 		while (m_locked.load(std::memory_order_acquire))
-		{ }
+		{
+			if (!JobSystemManager::RunPendingJob())
+			{
+				std::this_thread::yield();
+			}
+		}
+		if (trace)
+		{
+			trace->Record(TraceEventType::WaitEnd);
+		}
+		if (m_exception)
+		{
+			std::rethrow_exception(m_exception);
+		}
+	}
+
+	void JobResultBase::WaitForResult() const
+	{
+		// Wait on the result rather than the job, a recurring job sets its result long before it finishes.
+		while (!IsReady())
+		{
+			if (m_job && m_job->IsCancled() && !IsReady())
+			{
+				// Canceled jobs never run (skipped children carry an exception and are ready).
+				throw std::runtime_error("Job was canceled!");
+			}
+			if (!JobSystemManager::RunPendingJob())
+			{
+				std::this_thread::yield();
+			}
+		}
 	}
 
 	void JobWaitList::AddJobToWaitOn(JobSharedPtr job)
@@ -56,6 +183,11 @@ namespace Insight::JS
 
 	void JobWaitList::Wait()
 	{
+		TraceBuffer* trace = TraceBuffer::GetCurrent();
+		if (trace)
+		{
+			trace->Record(TraceEventType::WaitBegin);
+		}
 		bool waitting = true;
 		while (waitting)
 		{
@@ -68,6 +200,22 @@ namespace Insight::JS
 					break;
 				}
 			}
+			if (waitting && !JobSystemManager::RunPendingJob())
+			{
+				std::this_thread::yield();
+			}
+		}
+		if (trace)
+		{
+			trace->Record(TraceEventType::WaitEnd);
+		}
+		// Every job has finished, rethrow the first exception.
+		for (auto& job : m_jobsToWaitOn)
+		{
+			if (job->m_exception)
+			{
+				std::rethrow_exception(job->m_exception);
+			}
 		}
 	}
 }
\ No newline at end of file
@@ -2,16 +2,70 @@
 #include "Thread.h"
 #include <thread>
 #include <iostream>
+#include <fstream>
 #include <algorithm>
 
 namespace Insight::JS
 {
+	// Busy workers check timers, and a continuation chain run inline goes back through the queues, every this many jobs.
+	static constexpr uint32_t c_JobsBetweenChecks = 32;
+
 	JobQueue::JobQueue(JobQueueOptions options)
 		: m_highPriorityQueue(options.HighPriorityQueueSize)
 		, m_normalPriorityQueue(options.NormalPriorityQueueSize)
 		, m_lowPriorityQueue(options.LowPriorityQueueSize)
-		, m_jobRunningQueue(options.LowPriorityQueueSize)
-	{ }
+		, m_deadlineQueue(options.DeadlineQueueShards)
+		, m_clockStart(TraceClockCalibration::Capture())
+	{
+		SetSchedulingOptions(JobSchedulingOptions());
+	}
+
+	void JobQueue::SetSchedulingOptions(JobSchedulingOptions const& options)
+	{
+		m_schedulingOptions = options;
+
+		// Smooth weighted round robin, spreads each priority's turns evenly through the round
+		// instead of giving High all its turns in a row.
+		std::array<int64_t, 3> const weights =
+		{
+			std::max<uint32_t>(options.HighWeight, 1),
+			std::max<uint32_t>(options.NormalWeight, 1),
+			std::max<uint32_t>(options.LowWeight, 1),
+		};
+		int64_t const totalWeight = weights[0] + weights[1] + weights[2];
+		std::array<int64_t, 3> current = { };
+		m_weightedOrder.clear();
+		for (int64_t i = 0; i < totalWeight; ++i)
+		{
+			uint32_t selected = 0;
+			for (uint32_t priority = 0; priority < 3; ++priority)
+			{
+				current[priority] += weights[priority];
+				if (current[priority] > current[selected])
+				{
+					selected = priority;
+				}
+			}
+			current[selected] -= totalWeight;
+			m_weightedOrder.push_back(static_cast<JobPriority>(selected));
+		}
+
+		uint64_t const now = TraceClock::NowNanoseconds();
+		for (std::atomic<uint64_t>& agingSince : m_agingSinceNs)
+		{
+			agingSince.store(now, std::memory_order_relaxed);
+		}
+	}
+
+	uint64_t JobQueue::GetWaitNanoseconds(IJob const& job, uint64_t nowNs) const
+	{
+		// TraceClock ticks aren't nanoseconds on every platform, convert with the rate since the queue was created.
+		uint64_t const nowTicks = TraceClock::Now();
+		uint64_t const elapsedTicks = nowTicks - m_clockStart.Ticks;
+		double const nanosecondsPerTick = elapsedTicks > 0 ? static_cast<double>(nowNs - m_clockStart.Nanoseconds) / static_cast<double>(elapsedTicks) : 1.0;
+		uint64_t const waitTicks = nowTicks > job.m_scheduledTicks ? nowTicks - job.m_scheduledTicks : 0;
+		return static_cast<uint64_t>(static_cast<double>(waitTicks) * nanosecondsPerTick);
+	}
 
 	void JobQueue::Update(uint32_t const& jobsToFree)
 	{ }
@@ -41,12 +95,31 @@ namespace Insight::JS
 			return;
 		}
 
+		jobToSchedule->m_scheduledTicks = TraceClock::Now();
+		jobToSchedule->m_scheduledPriority = priority;
 		if (!queue->enqueue(jobToSchedule))
 		{
+			m_queueFullEvents.fetch_add(1, std::memory_order_relaxed);
+			if (Thread* thread = Thread::GetCurrent())
+			{
+				ThreadStats::Add(thread->GetStats().QueueFullEvents, 1);
+			}
 			throw std::overflow_error("Job Queue is full!");
 		}
 	}
 
+	void JobQueue::ScheduleJobWithDeadline(const JobSharedPtr& job, uint64_t deadline)
+	{
+		job->m_deadline = deadline;
+		job->m_scheduledTicks = TraceClock::Now();
+		job->m_scheduledPriority = job->m_priority;
+
+		// Workers push onto their own heap, other threads are spread by thread id.
+		Thread* thread = Thread::GetCurrent();
+		uint32_t const shardHint = thread ? thread->GetTLS()->ThreadIndex : static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+		m_deadlineQueue.Enqueue(job, shardHint);
+	}
+
 	LockFreeQueue<JobSharedPtr>* JobQueue::GetQueueByPriority(JobPriority priority)
 	{
 		switch (priority)
@@ -66,9 +139,117 @@ namespace Insight::JS
 	}
 
 	bool JobQueue::GetNextJob(JobSharedPtr& job)
+	{
+		FinishJob(job);
+
+		if (m_deadlineQueue.Dequeue(job))
+		{
+			m_runningJobs.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		LockFreeQueue<JobSharedPtr>* firstQueue = SelectQueue();
+		LockFreeQueue<JobSharedPtr>* dequeuedFrom = nullptr;
+		if (firstQueue && firstQueue->dequeue(job))
+		{
+			dequeuedFrom = firstQueue;
+		}
+		else
+		{
+			for (LockFreeQueue<JobSharedPtr>* queue : { &m_highPriorityQueue, &m_normalPriorityQueue, &m_lowPriorityQueue })
+			{
+				if (queue != firstQueue && queue->dequeue(job))
+				{
+					dequeuedFrom = queue;
+					break;
+				}
+			}
+		}
+		if (!dequeuedFrom)
+		{
+			return false;
+		}
+
+		if (m_schedulingOptions.Policy == JobSchedulingPolicy::Aging)
+		{
+			// The jobs still queued were queued after this one, so none has waited longer than since its queue time.
+			// Jobs queued together as one aged stay aged and follow each other, instead of one per aging interval.
+			uint64_t const now = TraceClock::NowNanoseconds();
+			m_agingSinceNs[dequeuedFrom == &m_highPriorityQueue ? 0 : (dequeuedFrom == &m_normalPriorityQueue ? 1 : 2)]
+				.store(now - std::min(now, GetWaitNanoseconds(*job, now)), std::memory_order_relaxed);
+		}
+		m_runningJobs.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	LockFreeQueue<JobSharedPtr>* JobQueue::SelectQueue()
+	{
+		switch (m_schedulingOptions.Policy)
+		{
+			case JobSchedulingPolicy::WeightedFair:
+			{
+				uint64_t const ticket = m_dequeueTicket.fetch_add(1, std::memory_order_relaxed);
+				return GetQueueByPriority(m_weightedOrder[ticket % m_weightedOrder.size()]);
+			}
+
+			case JobSchedulingPolicy::Aging:
+			{
+				// Lowest priority first, so an aged Low queue is not passed over for an aged Normal one forever.
+				uint64_t const now = TraceClock::NowNanoseconds();
+				std::array<std::pair<JobPriority, uint32_t>, 2> const agingQueues =
+				{
+					std::make_pair(JobPriority::Low, m_schedulingOptions.LowAgingMs),
+					std::make_pair(JobPriority::Normal, m_schedulingOptions.NormalAgingMs),
+				};
+				for (auto const& [priority, agingMs] : agingQueues)
+				{
+					LockFreeQueue<JobSharedPtr>* queue = GetQueueByPriority(priority);
+					std::atomic<uint64_t>& agingSince = m_agingSinceNs[static_cast<uint8_t>(priority)];
+					if (queue->size() == 0)
+					{
+						// An empty queue is not waiting, don't let its first job jump the other queues.
+						agingSince.store(now, std::memory_order_relaxed);
+					}
+					else if (now - std::min(now, agingSince.load(std::memory_order_relaxed)) >= agingMs * 1000000ull)
+					{
+						return queue;
+					}
+				}
+				return nullptr;
+			}
+
+			case JobSchedulingPolicy::Strict:
+			default:
+				return nullptr;
+		}
+	}
+
+	bool JobQueue::HasMoreUrgentJobs(JobPriority priority) const
+	{
+		return m_deadlineQueue.size() > 0
+			|| (priority != JobPriority::High && m_highPriorityQueue.size() > 0)
+			|| (priority == JobPriority::Low && m_normalPriorityQueue.size() > 0);
+	}
+
+	void JobQueue::FinishJob(JobSharedPtr& job, bool takeContinuation)
 	{
 		if (job != nullptr)
 		{
+			JobSharedPtr continuation = nullptr;
+			CompleteJob(job, JobState::Finished, takeContinuation ? &continuation : nullptr);
+			// A continuation taken over stays counted as running.
+			job = std::move(continuation);
+			if (!job)
+			{
+				m_runningJobs.fetch_sub(1, std::memory_order_relaxed);
+			}
+		}
+	}
+
+	void JobQueue::CompleteJob(JobSharedPtr const& job, JobState state, JobSharedPtr* continuation)
+	{
+		{
+			std::unique_lock childrenLock(job->m_childrenMutex);
 			//IJob* parentJob = job->m_parentJob;
 			//// Check if parent job have move children 
 			//if (parentJob)
@@ -88,26 +269,50 @@ namespace Insight::JS
 				++job->m_currentChildJob;
 				job->SetState(JobState::Waiting);
 				//return job = job->m_childrenJobs[i];
-				ScheduleJob(job->m_priority, job->m_childrenJobs[i], false);
+				JobSharedPtr const& child = job->m_childrenJobs[i];
+				if (!child->OnParentFinished(state == JobState::Canceled && !job->m_exception))
+				{
+					// Waiting on other parents (WhenAll), or another parent scheduled it already (WhenAny).
+					continue;
+				}
+				if (job->m_exception && child->m_exceptionPolicy == JobExceptionPolicy::CancelOnParentException)
+				{
+					// Skip the child and its children, waiting on them rethrows this job's exception.
+					child->m_jobSystem = job->m_jobSystem;
+					child->SetException(job->m_exception);
+					CompleteJob(child, JobState::Canceled);
+				}
+				else if (continuation && !*continuation)
+				{
+					// The first child runs next on this thread, skipping the queue while the parent's data is in its cache.
+					child->m_jobSystem = job->m_jobSystem;
+					child->m_scheduledTicks = TraceClock::Now();
+					child->m_scheduledPriority = job->m_priority;
+					*continuation = child;
+				}
+				else if (job->m_jobSystem)
+				{
+					job->m_jobSystem->ScheduleJob(job->m_priority, child, false);
+				}
+				else
+				{
+					ScheduleJob(job->m_priority, child, false);
+				}
 			}
 
-			job->SetState(JobState::Finished);
+			job->SetState(state);
+			childrenLock.unlock();
 			job->ReleaseLock();
-			job = nullptr;
 		}
-
-		return m_highPriorityQueue.dequeue(job) ||
-			   m_normalPriorityQueue.dequeue(job) ||
-			   m_lowPriorityQueue.dequeue(job);
 	}
 
 	void JobQueue::Release()
 	{
 		JobSharedPtr job;
-		while(m_highPriorityQueue.dequeue(job) || m_normalPriorityQueue.dequeue(job) || m_lowPriorityQueue.dequeue(job))
+		while(m_highPriorityQueue.dequeue(job) || m_normalPriorityQueue.dequeue(job) || m_lowPriorityQueue.dequeue(job) || m_deadlineQueue.Dequeue(job))
 		{
-			job->SetState(JobState::Canceled);
-			job->ReleaseLock();
+			// Children land back in a queue, ones queued here are cancelled by this loop too.
+			CompleteJob(job, JobState::Canceled);
 		}
 	}
 
@@ -152,21 +357,221 @@ namespace Insight::JS
 
 	void JobSystem::ScheduleJob(JobPriority priority, const JobSharedPtr & job, bool GetParentJob)
 	{
+		job->m_jobSystem = this;
 		m_queue.ScheduleJob(priority, job, GetParentJob);
 	}
 
+	void JobSystem::ScheduleJob(JobAffinity const& affinity, const JobSharedPtr& job)
+	{
+		job->m_jobSystem = this;
+		m_manager->PostToMailbox(affinity, job);
+	}
+
+	void JobSystem::ScheduleJobWithDeadline(const JobSharedPtr& job, std::chrono::steady_clock::time_point deadline)
+	{
+		job->m_jobSystem = this;
+		m_queue.ScheduleJobWithDeadline(job, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count()));
+	}
+
+	TimerHandle JobSystem::ScheduleJobAfter(const JobSharedPtr& job, std::chrono::steady_clock::duration delay)
+	{
+		return ScheduleJobAt(job, std::chrono::steady_clock::now() + delay);
+	}
+
+	TimerHandle JobSystem::ScheduleJobAt(const JobSharedPtr& job, std::chrono::steady_clock::time_point time)
+	{
+		if (time <= std::chrono::steady_clock::now())
+		{
+			ScheduleJob(job);
+			return TimerHandle();
+		}
+		job->m_jobSystem = this;
+		return m_timers.Add(job, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count()));
+	}
+
+	bool JobSystem::CancelTimer(TimerHandle const& handle)
+	{
+		if (handle.Wheel != &m_timers)
+		{
+			return false;
+		}
+		JobSharedPtr job = m_timers.Cancel(handle);
+		if (!job)
+		{
+			return false;
+		}
+		// Its children are scheduled, waiting on them must not hang.
+		m_queue.CompleteJob(job, JobState::Canceled);
+		return true;
+	}
+
+	void JobSystem::ScheduleJobEvery(const JobSharedPtr& job, std::chrono::steady_clock::duration period, JobRecurrenceOptions options)
+	{
+		if (job->m_recurrence)
+		{
+			// A run which fired before the cancel still uses the recurrence, it can only go once the job is done.
+			bool stopped = false;
+			{
+				std::lock_guard lock(job->m_recurrence->Mutex);
+				stopped = job->m_recurrence->Stopped;
+			}
+			if (!stopped || !(job->IsFinished() || job->IsCancled()))
+			{
+				throw std::logic_error("[JobSystem::ScheduleJobEvery] The job is already recurring. Cancel it with 'CancelRecurring' and wait for it first.");
+			}
+		}
+		job->m_recurrence = std::make_unique<JobRecurrence>();
+		job->m_jobSystem = this;
+		JobRecurrence& recurrence = *job->m_recurrence;
+		recurrence.Options = options;
+		recurrence.PeriodNs = static_cast<uint64_t>(std::max<int64_t>(1, std::chrono::duration_cast<std::chrono::nanoseconds>(period).count()));
+
+		std::lock_guard lock(recurrence.Mutex);
+		recurrence.NextRunNs = TraceClock::NowNanoseconds() + recurrence.PeriodNs;
+		recurrence.Timer = m_timers.Add(job, recurrence.NextRunNs);
+	}
+
+	bool JobSystem::CancelRecurring(const JobSharedPtr& job)
+	{
+		if (!job->m_recurrence)
+		{
+			return false;
+		}
+		TimerHandle timer;
+		{
+			std::lock_guard lock(job->m_recurrence->Mutex);
+			if (job->m_recurrence->Stopped)
+			{
+				return false;
+			}
+			job->m_recurrence->Stopped = true;
+			timer = job->m_recurrence->Timer;
+		}
+		// Nothing to do if the run has fired already, the job then finishes after that run.
+		JobSharedPtr const pending = job->m_jobSystem->m_timers.Cancel(timer);
+		if (pending && job->m_recurrence->Runs.load(std::memory_order_relaxed) == 0)
+		{
+			job->m_jobSystem->m_queue.CompleteJob(pending, JobState::Canceled);
+		}
+		else if (pending)
+		{
+			// It has run, so finish it like its last run just ended and schedule its children.
+			job->m_jobSystem->m_queue.CompleteJob(pending);
+		}
+		return true;
+	}
+
+	bool JobSystem::ScheduleNextRun(const JobSharedPtr& job)
+	{
+		JobRecurrence& recurrence = *job->m_recurrence;
+		std::lock_guard lock(recurrence.Mutex);
+		recurrence.Runs.fetch_add(1, std::memory_order_relaxed);
+		if (recurrence.Stopped)
+		{
+			return false;
+		}
+
+		uint64_t const now = TraceClock::NowNanoseconds();
+		uint64_t const period = recurrence.PeriodNs;
+		// Fixed rate counts from when the run was due, not when it happened to run, so it doesn't drift.
+		uint64_t next = recurrence.Options.Mode == JobRecurrenceMode::FixedDelay ? now + period : recurrence.NextRunNs + period;
+		if (next <= now)
+		{
+			uint64_t const missed = (now - next) / period + 1;
+			if (recurrence.Options.MissedPeriods == JobMissedPeriods::Skip)
+			{
+				next += missed * period;
+				recurrence.MissedPeriods.fetch_add(missed, std::memory_order_relaxed);
+			}
+			else
+			{
+				// Due at the latest missed period, which fires on the next tick.
+				next += (missed - 1) * period;
+				recurrence.MissedPeriods.fetch_add(missed - 1, std::memory_order_relaxed);
+			}
+		}
+		recurrence.NextRunNs = next;
+		job->SetState(JobState::Queued);
+		recurrence.Timer = m_timers.Add(job, next);
+		return true;
+	}
+
+	bool JobSystem::ServiceTimers()
+	{
+		if (m_timers.GetPendingCount() == 0 && m_overdueTimerCount.load(std::memory_order_acquire) == 0)
+		{
+			return false;
+		}
+		thread_local std::vector<JobSharedPtr> expired;
+		if (m_overdueTimerCount.load(std::memory_order_acquire) > 0)
+		{
+			std::lock_guard lock(m_overdueTimerMutex);
+			expired.swap(m_overdueTimerJobs);
+			m_overdueTimerCount.store(0, std::memory_order_release);
+		}
+		if (m_timers.GetPendingCount() > 0)
+		{
+			m_timers.TryAdvance(TraceClock::NowNanoseconds(), expired);
+		}
+		if (expired.empty())
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < expired.size(); ++i)
+		{
+			try
+			{
+				ScheduleJob(expired[i]);
+			}
+			catch (std::overflow_error const&)
+			{
+				// Many timers expired at once, retry the rest next time. They are not put back on the wheel,
+				// that would give them new handles and the handles their owners hold could no longer cancel them.
+				std::lock_guard lock(m_overdueTimerMutex);
+				m_overdueTimerJobs.insert(m_overdueTimerJobs.end(), std::make_move_iterator(expired.begin() + i), std::make_move_iterator(expired.end()));
+				m_overdueTimerCount.store(static_cast<uint32_t>(m_overdueTimerJobs.size()), std::memory_order_release);
+				break;
+			}
+		}
+		expired.clear();
+		return true;
+	}
+
+	void JobSystem::ScheduleBlocking(const JobSharedPtr& job)
+	{
+		if (m_manager->GetNumBlockingThreads() == 0)
+		{
+			ScheduleJob(job);
+			return;
+		}
+		// Continuations come back to this job system, only the blocking job itself runs on the blocking pool.
+		job->m_jobSystem = this;
+		m_manager->m_blockingJobSystem.m_queue.ScheduleJob(job->m_priority, job, false);
+	}
+
+	JobWithResultSharedPtr<Buffer> JobSystem::ReadFileAsync(std::string const& path, uint64_t offset, uint64_t size, JobPriority priority)
+	{
+		return m_manager->m_asyncIO.ReadFile(*this, path, offset, size, priority);
+	}
+
 	void JobSystem::WaitForAll() const
 	{
-		//TODO:
+		// Jobs of this job system may be waiting for the main thread, run them if we are it.
+		bool const isMainThread = m_manager && std::this_thread::get_id() == m_manager->GetMainThreadId();
 		while(GetPendingJobsCount() > 0 || GetRunningJobsCount() > 0)
 		{
-			Thread::SleepFor(1);
+			if (!isMainThread || m_manager->RunMainThreadJobs(MainThreadBudget()) == 0)
+			{
+				Thread::SleepFor(1);
+			}
 		}
 	}
 
 	void JobSystem::Update(uint32_t const& jobsToFree)
 	{
 		m_queue.Update(jobsToFree);
+		ServiceTimers();
 	}
 
 	uint8_t JobSystem::GetCurrentThreadIndex() const
@@ -207,6 +612,18 @@ namespace Insight::JS
 		return m_queue.GetNextJob(job);
 	}
 
+	void JobSystem::FinishJob(JobSharedPtr& job, bool takeContinuation)
+	{
+		if (job != nullptr && job->m_recurrence && ScheduleNextRun(job))
+		{
+			// Not finished, the job stays locked and keeps its children until it is cancelled.
+			job = nullptr;
+			m_queue.m_runningJobs.fetch_sub(1, std::memory_order_relaxed);
+			return;
+		}
+		m_queue.FinishJob(job, takeContinuation);
+	}
+
 	void JobSystem::AddThreads(std::vector<Thread*> threads)
 	{
 		m_threads.insert(m_threads.end(), threads.begin(), threads.end());
@@ -224,6 +641,19 @@ namespace Insight::JS
 
 	void JobSystem::ClearQueue()
 	{
+		std::vector<JobSharedPtr> timerJobs;
+		m_timers.Clear(timerJobs);
+		{
+			std::lock_guard lock(m_overdueTimerMutex);
+			timerJobs.insert(timerJobs.end(), std::make_move_iterator(m_overdueTimerJobs.begin()), std::make_move_iterator(m_overdueTimerJobs.end()));
+			m_overdueTimerJobs.clear();
+			m_overdueTimerCount.store(0, std::memory_order_release);
+		}
+		for (JobSharedPtr const& job : timerJobs)
+		{
+			m_queue.CompleteJob(job, JobState::Canceled);
+		}
+		// After the timers, children they scheduled here are cancelled with the rest of the queue.
 		m_queue.Release();
 	}
 
@@ -257,6 +687,11 @@ namespace Insight::JS
 		}
 		Shutdown(true);
 		delete[] m_allThreads;
+		delete[] m_blockingThreads;
+		if (m_mainThreadTrace && TraceBuffer::GetCurrent() == m_mainThreadTrace.get())
+		{
+			TraceBuffer::SetCurrent(nullptr);
+		}
 	}
 
 	JobSystemManager::ReturnCode JobSystemManager::Init(const JobSystemManagerOptions& options)
@@ -278,8 +713,18 @@ namespace Insight::JS
 		// Threads
 		m_allThreads = new Thread[m_current_options.NumThreads];
 
-		// Current (Main) Thread
+		// Current (Main) Thread. Set on the job systems before anything can fail, so Shutdown works on a partly initialised manager.
 		m_mainThreadId = std::this_thread::get_id();
+		m_mainJobSystem.m_mainThreadId = GetMainThreadId();
+		m_blockingJobSystem.m_mainThreadId = GetMainThreadId();
+
+		// Tracing buffers must exist before the threads start.
+		m_clockStart = TraceClockCalibration::Capture();
+		if (m_current_options.EnableTracing)
+		{
+			m_mainThreadTrace = std::make_unique<TraceBuffer>(m_current_options.TraceEventsPerThread);
+			TraceBuffer::SetCurrent(m_mainThreadTrace.get());
+		}
 
 		// Thread Affinity
 		if (m_current_options.ThreadAffinity && m_current_options.NumThreads > hardware_thread_count)
@@ -287,6 +732,16 @@ namespace Insight::JS
 			return ReturnCode::ErrorThreadAffinity;
 		}
 
+		// Workers read the scheduling options without locks, set them before any worker starts.
+		m_mainJobSystem.m_queue.SetSchedulingOptions(m_current_options.Scheduling);
+
+		// Mailboxes too, workers look their own one up when they start.
+		for (uint32_t i = 0; i < m_current_options.NumThreads; ++i)
+		{
+			m_workerMailboxes.push_back(std::make_unique<LockFreeQueue<JobSharedPtr>>(m_current_options.WorkerMailboxSize));
+		}
+		m_mainThreadMailbox = std::make_unique<LockFreeQueue<JobSharedPtr>>(m_current_options.MainThreadMailboxSize);
+
 		std::vector<Thread*> spawnedThreads;
 		// Spawn Threads
 		for (uint8_t i = 0; i < m_current_options.NumThreads; i++)
@@ -296,6 +751,14 @@ namespace Insight::JS
 			ttls->SetAffinity = m_current_options.ThreadAffinity;
 
 			m_allThreads[i].SetThreadData(this, &m_mainJobSystem);
+			if (m_current_options.EnableTracing)
+			{
+				m_allThreads[i].EnableTracing(m_current_options.TraceEventsPerThread);
+			}
+			if (m_current_options.RecordLatencyHistograms)
+			{
+				m_allThreads[i].EnableLatencyHistograms();
+			}
 			if (!m_allThreads[i].Spawn(ThreadCallback_Worker))
 			{
 				return ReturnCode::OSError;
@@ -303,17 +766,60 @@ namespace Insight::JS
 			spawnedThreads.push_back(&m_allThreads[i]);
 		}
 		m_mainJobSystem.m_manager = this;
-		m_mainJobSystem.m_mainThreadId = GetMainThreadId();
 		m_mainJobSystem.m_numThreads = m_current_options.NumThreads;
+		// The main job system is the shared pool. It lends idle threads to elastic job systems
+		// (keeping at least one for itself) but only borrows when elastic job systems are idle.
+		m_mainJobSystem.m_elasticOptions.Enabled = true;
+		m_mainJobSystem.m_elasticOptions.MinThreads = 1;
 		m_mainJobSystem.AddThreads(spawnedThreads);
+		m_lastElasticSample = std::chrono::steady_clock::now();
+
+		// Blocking Threads. These are allowed to oversubscribe the cores as they spend most of their time waiting.
+		m_blockingJobSystem.m_manager = this;
+		if (m_current_options.NumBlockingThreads > 0)
+		{
+			m_blockingThreads = new Thread[m_current_options.NumBlockingThreads];
+			std::vector<Thread*> blockingThreads;
+			for (uint32_t i = 0; i < m_current_options.NumBlockingThreads; i++)
+			{
+				TLS* ttls = m_blockingThreads[i].GetTLS();
+				ttls->ThreadIndex = static_cast<uint8_t>(std::min<uint32_t>(m_current_options.NumThreads + i, UINT8_MAX - 1));
+				ttls->SetAffinity = false;
+
+				m_blockingThreads[i].SetThreadData(this, &m_blockingJobSystem);
+				if (m_current_options.EnableTracing)
+				{
+					m_blockingThreads[i].EnableTracing(m_current_options.TraceEventsPerThread);
+				}
+				if (m_current_options.RecordLatencyHistograms)
+				{
+					m_blockingThreads[i].EnableLatencyHistograms();
+				}
+				if (!m_blockingThreads[i].Spawn(ThreadCallback_Worker))
+				{
+					return ReturnCode::OSError;
+				}
+				blockingThreads.push_back(&m_blockingThreads[i]);
+			}
+			m_blockingJobSystem.AddThreads(blockingThreads);
+		}
+		else
+		{
+			std::cout << "[JobSystemManager::Init] No blocking threads, blocking jobs will run on the job system they are scheduled on." << '\n';
+		}
+
+		// Async I/O falls back to the blocking threads if io_uring can not be used.
+		m_asyncIO.Init(m_current_options.AsyncIOQueueDepth);
 
 		// Done
 		return ReturnCode::Succes;
 	}
 
-	std::shared_ptr<JobSystem> JobSystemManager::CreateLocalJobSystem(uint32_t numThreads)
+	std::shared_ptr<JobSystem> JobSystemManager::CreateLocalJobSystem(uint32_t numThreads, JobSystemElasticOptions elasticOptions, JobSchedulingOptions schedulingOptions)
 	{
 		std::shared_ptr<JobSystem> jobSystem = std::make_shared<JobSystem>(this, m_mainThreadId);
+		jobSystem->m_elasticOptions = elasticOptions;
+		jobSystem->m_queue.SetSchedulingOptions(schedulingOptions);
 		ReseveThreads(*jobSystem.get(), numThreads);
 		m_jobSystems.push_back(jobSystem);
 		return jobSystem;
@@ -351,8 +857,27 @@ namespace Insight::JS
 
 	void JobSystemManager::ReleaseJobSystem(JobSystem& jobSystem)
 	{
+		// Take back any threads lent to the job system being released, and give its own threads to the main one.
+		std::vector<Thread*> users = jobSystem.m_threads;
+		for (uint32_t i = 0; i < m_current_options.NumThreads; ++i)
+		{
+			if (m_allThreads[i].GetUserdata().LentSystem == &jobSystem)
+			{
+				m_allThreads[i].SetLentSystem(nullptr);
+				users.push_back(&m_allThreads[i]);
+			}
+		}
 		m_mainJobSystem.AddThreads(jobSystem.m_threads);
 		jobSystem.RemoveThreads();
+		// They may still be getting, running or finishing a job of it, wait for them to leave before it goes.
+		// Not for the calling thread, it would wait for itself.
+		for (Thread* thread : users)
+		{
+			if (thread != Thread::GetCurrent())
+			{
+				thread->WaitForUserdataUsers();
+			}
+		}
 		jobSystem.ClearQueue();
 		m_jobSystems.erase(std::find_if(m_jobSystems.begin(), m_jobSystems.end(), [&jobSystem](std::shared_ptr<JobSystem> const& system) 
 						   {
@@ -362,12 +887,20 @@ namespace Insight::JS
 
 	void JobSystemManager::Shutdown(bool blocking)
 	{
+		if (!m_allThreads)
+		{
+			// Never initialised (or Init failed before creating any thread), nothing to stop.
+			return;
+		}
+		// Let in flight reads complete before the workers stop.
+		m_asyncIO.Release();
 		m_shuttingDown.store(true, std::memory_order_release);
 		for (std::shared_ptr<JobSystem>& js : m_jobSystems)
 		{
 			js->Shutdown(blocking);
 		}
 		m_mainJobSystem.Shutdown(blocking);
+		m_blockingJobSystem.Shutdown(blocking);
 	}
 
 	void JobSystemManager::ScheduleJob(const JobSharedPtr job)
@@ -380,14 +913,282 @@ namespace Insight::JS
 		m_mainJobSystem.ScheduleJob(priority, job, GetParentJob);
 	}
 
-	void JobSystemManager::WaitForAll() const
+	void JobSystemManager::ScheduleJob(JobAffinity const& affinity, const JobSharedPtr& job)
+	{
+		m_mainJobSystem.ScheduleJob(affinity, job);
+	}
+
+	void JobSystemManager::ScheduleJobWithDeadline(const JobSharedPtr& job, std::chrono::steady_clock::time_point deadline)
+	{
+		m_mainJobSystem.ScheduleJobWithDeadline(job, deadline);
+	}
+
+	void JobSystemManager::PostToMailbox(JobAffinity const& affinity, const JobSharedPtr& job)
+	{
+		LockFreeQueue<JobSharedPtr>* mailbox = nullptr;
+		if (affinity.MainThreadOnly)
+		{
+			mailbox = m_mainThreadMailbox.get();
+		}
+		else
+		{
+			for (uint32_t i = 0; i < m_workerMailboxes.size() && i < 64; ++i)
+			{
+				if ((affinity.WorkerMask & (1ull << i)) != 0 && (!mailbox || m_workerMailboxes[i]->size() < mailbox->size()))
+				{
+					mailbox = m_workerMailboxes[i].get();
+				}
+			}
+		}
+		if (!mailbox)
+		{
+			throw std::invalid_argument("Job affinity has no worker!");
+		}
+
+		// Count the job before it can be taken, so the count never goes below zero.
+		JobQueue& queue = job->m_jobSystem->m_queue;
+		job->m_scheduledTicks = TraceClock::Now();
+		job->m_scheduledPriority = job->m_priority;
+		queue.m_mailboxJobs.fetch_add(1, std::memory_order_release);
+		if (!mailbox->enqueue(job))
+		{
+			queue.m_mailboxJobs.fetch_sub(1, std::memory_order_release);
+			queue.m_queueFullEvents.fetch_add(1, std::memory_order_relaxed);
+			if (Thread* thread = Thread::GetCurrent())
+			{
+				ThreadStats::Add(thread->GetStats().QueueFullEvents, 1);
+			}
+			throw std::overflow_error("Job Queue is full!");
+		}
+	}
+
+	bool JobSystemManager::TakeMailboxJob(LockFreeQueue<JobSharedPtr>& mailbox, JobSharedPtr& job)
+	{
+		if (mailbox.size() == 0 || !mailbox.dequeue(job))
+		{
+			return false;
+		}
+		JobQueue& queue = job->m_jobSystem->m_queue;
+		queue.m_runningJobs.fetch_add(1, std::memory_order_relaxed);
+		queue.m_mailboxJobs.fetch_sub(1, std::memory_order_release);
+		return true;
+	}
+
+	uint32_t JobSystemManager::RunMainThreadJobs(MainThreadBudget const& budget)
+	{
+		if (!m_mainThreadMailbox)
+		{
+			return 0;
+		}
+		assert(std::this_thread::get_id() == GetMainThreadId() && "[JobSystemManager::RunMainThreadJobs] Main thread jobs must run on the 'MainThread'.");
+
+		// Only the jobs already waiting, jobs posting more main thread jobs can't keep Update from returning.
+		uint32_t const jobsToRun = std::min(m_mainThreadMailbox->size(), budget.MaxJobs);
+		// Only read the clock when there is a time budget.
+		bool const timed = budget.MaxTime != std::chrono::microseconds::max();
+		uint64_t const endNs = timed ? TraceClock::NowNanoseconds() + std::chrono::duration_cast<std::chrono::nanoseconds>(budget.MaxTime).count() : 0;
+		TraceBuffer* trace = TraceBuffer::GetCurrent();
+		JobSharedPtr job = nullptr;
+		uint32_t jobsRun = 0;
+		while (jobsRun < jobsToRun && TakeMailboxJob(*m_mainThreadMailbox, job))
+		{
+			if (trace)
+			{
+				trace->Record(TraceEventType::JobBegin, job->GetName());
+			}
+			job->Call();
+			if (trace)
+			{
+				trace->Record(TraceEventType::JobEnd);
+			}
+			// Continuations go to the workers, they are not tied to the main thread.
+			job->m_jobSystem->FinishJob(job, false);
+			++jobsRun;
+
+			if (timed && TraceClock::NowNanoseconds() >= endNs)
+			{
+				break;
+			}
+		}
+		return jobsRun;
+	}
+
+	TimerHandle JobSystemManager::ScheduleJobAfter(const JobSharedPtr& job, std::chrono::steady_clock::duration delay)
+	{
+		return m_mainJobSystem.ScheduleJobAfter(job, delay);
+	}
+
+	TimerHandle JobSystemManager::ScheduleJobAt(const JobSharedPtr& job, std::chrono::steady_clock::time_point time)
+	{
+		return m_mainJobSystem.ScheduleJobAt(job, time);
+	}
+
+	bool JobSystemManager::CancelTimer(TimerHandle const& handle)
+	{
+		if (handle.Wheel == &m_mainJobSystem.m_timers)
+		{
+			return m_mainJobSystem.CancelTimer(handle);
+		}
+		for (std::shared_ptr<JobSystem> const& js : m_jobSystems)
+		{
+			if (handle.Wheel == &js->m_timers)
+			{
+				return js->CancelTimer(handle);
+			}
+		}
+		return false;
+	}
+
+	void JobSystemManager::ScheduleJobEvery(const JobSharedPtr& job, std::chrono::steady_clock::duration period, JobRecurrenceOptions options)
 	{
+		m_mainJobSystem.ScheduleJobEvery(job, period, options);
+	}
 
+	bool JobSystemManager::CancelRecurring(const JobSharedPtr& job)
+	{
+		return job->m_jobSystem ? job->m_jobSystem->CancelRecurring(job) : false;
+	}
+
+	void JobSystemManager::ScheduleBlocking(const JobSharedPtr& job)
+	{
+		m_mainJobSystem.ScheduleBlocking(job);
+	}
+
+	JobWithResultSharedPtr<Buffer> JobSystemManager::ReadFileAsync(std::string const& path, uint64_t offset, uint64_t size, JobPriority priority)
+	{
+		return m_mainJobSystem.ReadFileAsync(path, offset, size, priority);
+	}
+
+	void JobSystemManager::WaitForAll()
+	{
+		auto hasWork = [this]()
+		{
+			uint32_t jobs = GetPendingJobsCount() + GetRunningJobsCount() + m_blockingJobSystem.GetPendingJobsCount() + m_blockingJobSystem.GetRunningJobsCount();
+			for (std::shared_ptr<JobSystem> const& js : m_jobSystems)
+			{
+				jobs += js->GetPendingJobsCount();
+			}
+			return jobs > 0;
+		};
+
+		// Workers may be waiting on main thread jobs, so only sleep when there are none to run.
+		bool const isMainThread = std::this_thread::get_id() == GetMainThreadId();
+		while (hasWork())
+		{
+			if (!isMainThread || RunMainThreadJobs(MainThreadBudget()) == 0)
+			{
+				Thread::SleepFor(1);
+			}
+		}
 	}
 
 	void JobSystemManager::Update(uint32_t const& jobsToFree)
+	{
+		Update(MainThreadBudget(), jobsToFree);
+	}
+
+	void JobSystemManager::Update(MainThreadBudget const& mainThreadBudget, uint32_t const& jobsToFree)
 	{
 		m_mainJobSystem.Update(jobsToFree);
+		RunMainThreadJobs(mainThreadBudget);
+
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (now - m_lastElasticSample >= std::chrono::milliseconds(m_current_options.ElasticSampleIntervalMs))
+		{
+			m_lastElasticSample = now;
+			BalanceElasticJobSystems();
+		}
+	}
+
+	void JobSystemManager::BalanceElasticJobSystems()
+	{
+		if (!m_allThreads)
+		{
+			return;
+		}
+
+		std::vector<JobSystem*> elasticSystems;
+		elasticSystems.push_back(&m_mainJobSystem);
+		for (std::shared_ptr<JobSystem> const& js : m_jobSystems)
+		{
+			if (js->IsElastic())
+			{
+				elasticSystems.push_back(js.get());
+			}
+		}
+		if (elasticSystems.size() < 2)
+		{
+			return;
+		}
+
+		// Return lent threads when the borrower has drained its queue or the lender needs them back.
+		for (uint32_t i = 0; i < m_current_options.NumThreads; ++i)
+		{
+			ThreadData tData = m_allThreads[i].GetUserdata();
+			if (tData.LentSystem
+				&& (tData.LentSystem->GetPendingJobsCount() == 0 || IsBacklogged(*tData.System)))
+			{
+				m_allThreads[i].SetLentSystem(nullptr);
+			}
+		}
+
+		// Lend at most one idle thread per backlogged job system each sample so the pools grow gradually.
+		for (JobSystem* receiver : elasticSystems)
+		{
+			JobSystemElasticOptions const& receiverOptions = receiver->GetElasticOptions();
+			if (!IsBacklogged(*receiver)
+				|| (receiverOptions.MaxThreads > 0 && GetWorkingThreadCount(*receiver) >= receiverOptions.MaxThreads))
+			{
+				continue;
+			}
+
+			for (JobSystem* donor : elasticSystems)
+			{
+				if (donor == receiver
+					|| donor->GetPendingJobsCount() > 0
+					|| donor->GetNumThreads() - GetLentThreadCount(*donor) <= donor->GetElasticOptions().MinThreads)
+				{
+					continue;
+				}
+
+				std::vector<Thread*>::iterator itr = std::find_if(donor->m_threads.begin(), donor->m_threads.end(), [](Thread* thread)
+																   {
+																	   return thread->GetUserdata().LentSystem == nullptr;
+																   });
+				if (itr != donor->m_threads.end())
+				{
+					(*itr)->SetLentSystem(receiver);
+					break;
+				}
+			}
+		}
+	}
+
+	uint32_t JobSystemManager::GetWorkingThreadCount(JobSystem const& jobSystem) const
+	{
+		uint32_t borrowedThreads = 0;
+		for (uint32_t i = 0; i < m_current_options.NumThreads; ++i)
+		{
+			if (m_allThreads[i].GetUserdata().LentSystem == &jobSystem)
+			{
+				++borrowedThreads;
+			}
+		}
+		return jobSystem.GetNumThreads() - GetLentThreadCount(jobSystem) + borrowedThreads;
+	}
+
+	uint32_t JobSystemManager::GetLentThreadCount(JobSystem const& jobSystem) const
+	{
+		return static_cast<uint32_t>(std::count_if(jobSystem.m_threads.begin(), jobSystem.m_threads.end(), [](Thread* thread)
+												   {
+													   return thread->GetUserdata().LentSystem != nullptr;
+												   }));
+	}
+
+	bool JobSystemManager::IsBacklogged(JobSystem const& jobSystem) const
+	{
+		uint32_t const workingThreads = std::max(GetWorkingThreadCount(jobSystem), 1u);
+		return jobSystem.GetPendingJobsCount() > workingThreads * m_current_options.ElasticBacklogFactor;
 	}
 
 	uint32_t JobSystemManager::GetCurrentThreadIndex() const
@@ -424,6 +1225,228 @@ namespace Insight::JS
 		return m_mainJobSystem.GetPendingJobsCount();
 	}
 
+	uint32_t JobSystemManager::GetPendingBlockingJobsCount() const
+	{
+		return m_blockingJobSystem.GetPendingJobsCount();
+	}
+
+	uint32_t JobSystemManager::GetRunningJobsCount() const
+	{
+		uint32_t runningJobs = m_mainJobSystem.GetRunningJobsCount();
+		for (std::shared_ptr<JobSystem> const& js : m_jobSystems)
+		{
+			runningJobs += js->GetRunningJobsCount();
+		}
+		return runningJobs;
+	}
+
+	JobSystemManagerStats JobSystemManager::GetStats() const
+	{
+		JobSystemManagerStats stats;
+		if (!m_allThreads)
+		{
+			return stats;
+		}
+
+		for (uint32_t i = 0; i < m_current_options.NumThreads; ++i)
+		{
+			stats.Threads.push_back(m_allThreads[i].GetStats().GetSnapshot());
+			stats.Total += stats.Threads.back();
+		}
+		for (uint32_t i = 0; m_blockingThreads && i < m_current_options.NumBlockingThreads; ++i)
+		{
+			stats.BlockingThreads.push_back(m_blockingThreads[i].GetStats().GetSnapshot());
+			stats.Total += stats.BlockingThreads.back();
+		}
+
+		stats.PendingJobs = GetPendingJobsCount() + GetPendingBlockingJobsCount();
+		stats.RunningJobs = GetRunningJobsCount() + m_blockingJobSystem.GetRunningJobsCount();
+		stats.QueueFullEvents = m_mainJobSystem.m_queue.GetQueueFullEvents() + m_blockingJobSystem.m_queue.GetQueueFullEvents();
+		for (std::shared_ptr<JobSystem> const& js : m_jobSystems)
+		{
+			stats.PendingJobs += js->GetPendingJobsCount();
+			stats.QueueFullEvents += js->m_queue.GetQueueFullEvents();
+		}
+		return stats;
+	}
+
+	JobLatencyStats JobSystemManager::GetLatencyStats(JobPriority priority) const
+	{
+		JobLatencyStats stats;
+		TraceClockCalibration const now = TraceClockCalibration::Capture();
+		if (now.Ticks > m_clockStart.Ticks)
+		{
+			stats.QueueWait.NanosecondsPerTick = static_cast<double>(now.Nanoseconds - m_clockStart.Nanoseconds) / static_cast<double>(now.Ticks - m_clockStart.Ticks);
+			stats.RunTime.NanosecondsPerTick = stats.QueueWait.NanosecondsPerTick;
+		}
+
+		uint8_t const priorityIndex = static_cast<uint8_t>(priority);
+		auto addThread = [&stats, priorityIndex](Thread const& thread)
+		{
+			if (JobLatencyHistograms const* histograms = thread.GetLatencyHistograms())
+			{
+				histograms->QueueWait[priorityIndex].AddTo(stats.QueueWait);
+				histograms->RunTime[priorityIndex].AddTo(stats.RunTime);
+			}
+		};
+		for (uint32_t i = 0; m_allThreads && i < m_current_options.NumThreads; ++i)
+		{
+			addThread(m_allThreads[i]);
+		}
+		for (uint32_t i = 0; m_blockingThreads && i < m_current_options.NumBlockingThreads; ++i)
+		{
+			addThread(m_blockingThreads[i]);
+		}
+		return stats;
+	}
+
+	std::map<std::string, PerfCounterValues> JobSystemManager::GetPerfCounters() const
+	{
+		std::map<std::string, PerfCounterValues> totals;
+#if defined(JS_ENABLE_PERF_COUNTERS)
+		for (uint32_t i = 0; m_allThreads && i < m_current_options.NumThreads; ++i)
+		{
+			m_allThreads[i].GetPerfCounters().AddTo(totals);
+		}
+		for (uint32_t i = 0; m_blockingThreads && i < m_current_options.NumBlockingThreads; ++i)
+		{
+			m_blockingThreads[i].GetPerfCounters().AddTo(totals);
+		}
+#endif
+		return totals;
+	}
+
+	bool JobSystemManager::WriteChromeTrace(std::string const& path) const
+	{
+		std::ofstream file(path);
+		if (!file.is_open())
+		{
+			std::cout << "[JobSystemManager::WriteChromeTrace] Could not open '" << path << "' for writing." << '\n';
+			return false;
+		}
+		WriteChromeTrace(file);
+		return true;
+	}
+
+	void JobSystemManager::WriteChromeTrace(std::ostream& stream) const
+	{
+		std::vector<TraceThread> threads;
+		if (m_mainThreadTrace)
+		{
+			TraceThread& thread = threads.emplace_back();
+			thread.Name = "Main";
+			m_mainThreadTrace->Read(thread.Events);
+		}
+		for (uint32_t i = 0; m_allThreads && i < m_current_options.NumThreads; ++i)
+		{
+			if (TraceBuffer* trace = m_allThreads[i].GetTraceBuffer())
+			{
+				TraceThread& thread = threads.emplace_back();
+				thread.Name = "Worker " + std::to_string(i);
+				trace->Read(thread.Events);
+			}
+		}
+		for (uint32_t i = 0; m_blockingThreads && i < m_current_options.NumBlockingThreads; ++i)
+		{
+			if (TraceBuffer* trace = m_blockingThreads[i].GetTraceBuffer())
+			{
+				TraceThread& thread = threads.emplace_back();
+				thread.Name = "Blocking " + std::to_string(i);
+				trace->Read(thread.Events);
+			}
+		}
+		Insight::JS::WriteChromeTrace(stream, threads, m_clockStart);
+	}
+
+	bool JobSystemManager::RunPendingJob()
+	{
+		Thread* thread = Thread::GetCurrent();
+		if (!thread)
+		{
+			return false;
+		}
+		UserdataScope userdata(*thread);
+		ThreadData const& tData = userdata.Get();
+		JobSharedPtr job = nullptr;
+		uint8_t const threadIndex = thread->GetTLS()->ThreadIndex;
+		if (tData.Manager && threadIndex < tData.Manager->m_workerMailboxes.size()
+			&& TakeMailboxJob(*tData.Manager->m_workerMailboxes[threadIndex], job))
+		{
+			ExecuteJob(*thread, *job->m_jobSystem, job);
+			return true;
+		}
+		JobSystem* system = tData.LentSystem;
+		if (!system || !system->GetNextJob(job))
+		{
+			system = tData.System;
+			if (!system || !system->GetNextJob(job))
+			{
+				return false;
+			}
+		}
+		ExecuteJob(*thread, *system, job);
+		return true;
+	}
+
+	uint32_t JobSystemManager::ExecuteJob(Thread& thread, JobSystem& system, JobSharedPtr& job)
+	{
+		ThreadStats& stats = thread.GetStats();
+		TraceBuffer* trace = thread.GetTraceBuffer();
+		JobLatencyHistograms* latencyHistograms = thread.GetLatencyHistograms();
+		// Blocking threads never run continuations, those belong on the compute workers.
+		ThreadData const tData = thread.GetUserdata();
+		bool const isBlockingThread = tData.Manager && tData.System == &tData.Manager->m_blockingJobSystem;
+		LockFreeQueue<JobSharedPtr>* mailbox = tData.Manager && thread.GetTLS()->ThreadIndex < tData.Manager->m_workerMailboxes.size()
+			? tData.Manager->m_workerMailboxes[thread.GetTLS()->ThreadIndex].get() : nullptr;
+
+		uint32_t jobsExecuted = 0;
+		while (job)
+		{
+			std::chrono::steady_clock::time_point const jobStart = std::chrono::steady_clock::now();
+			uint64_t const startTicks = latencyHistograms ? TraceClock::Now() : 0;
+			if (trace)
+			{
+				trace->Record(TraceEventType::JobBegin, job->GetName());
+			}
+			job->Call();
+			if (trace)
+			{
+				trace->Record(TraceEventType::JobEnd);
+			}
+			if (latencyHistograms)
+			{
+				// Cores' time stamp counters can be slightly apart, clamp instead of wrapping around.
+				uint8_t const priorityIndex = static_cast<uint8_t>(job->m_scheduledPriority);
+				uint64_t const endTicks = TraceClock::Now();
+				latencyHistograms->QueueWait[priorityIndex].Record(startTicks > job->m_scheduledTicks ? startTicks - job->m_scheduledTicks : 0);
+				latencyHistograms->RunTime[priorityIndex].Record(endTicks - startTicks);
+			}
+			ThreadStats::Add(stats.TimeInJobNs, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - jobStart).count());
+			ThreadStats::Add(stats.JobsExecuted, 1);
+			if (job->m_deadline != 0)
+			{
+				ThreadStats::Add(stats.DeadlineJobsExecuted, 1);
+				if (TraceClock::NowNanoseconds() > job->m_deadline)
+				{
+					ThreadStats::Add(stats.DeadlineMisses, 1);
+				}
+			}
+			++jobsExecuted;
+			// Hands over the job's first continuation, if it has one. Only while the job belongs to 'system', a job
+			// scheduled on another job system (ScheduleBlocking) queues its continuations there instead,
+			// so they run on its threads and are counted as running on it.
+			// A long chain, a deadline or higher priority job, a job pinned to this worker or a shutdown
+			// queues the continuation too, so they aren't kept waiting behind the chain.
+			bool const takeContinuation = !isBlockingThread && job->m_jobSystem == &system
+				&& jobsExecuted % c_JobsBetweenChecks != 0
+				&& !(tData.Manager && tData.Manager->IsShuttingDown())
+				&& !(mailbox && mailbox->size() > 0)
+				&& !system.m_queue.HasMoreUrgentJobs(job->m_priority);
+			system.FinishJob(job, takeContinuation);
+		}
+		return jobsExecuted;
+	}
+
 	void JobSystemManager::ThreadCallback_Worker(Thread* thread)
 	{
 		// This is where the thread will be executing.
@@ -441,19 +1464,85 @@ namespace Insight::JS
 			thread->SetAffinity(tls->ThreadIndex);
 		}
 
+#if defined(JS_ENABLE_PERF_COUNTERS)
+		// perf_event counters count the thread which opens them.
+		if (thread->GetPerfCounters().Open())
+		{
+			PerfCounters::SetCurrent(&thread->GetPerfCounters());
+		}
+#endif
+
 		JobSharedPtr job = nullptr;
 		JobSystemManager* js_manager = tData.Manager;
+		ThreadStats& stats = thread->GetStats();
+		uint32_t jobsSinceTimerCheck = 0;
+		TraceBuffer* trace = thread->GetTraceBuffer();
+		// Blocking threads have no mailbox.
+		LockFreeQueue<JobSharedPtr>* mailbox = tls->ThreadIndex < js_manager->m_workerMailboxes.size() ? js_manager->m_workerMailboxes[tls->ThreadIndex].get() : nullptr;
 		// Thread loop. Every thread will be running this loop looking for new jobs to execute.
 		while (!js_manager->IsShuttingDown())
 		{
-			// Get the user data as the system this thread is assigned to could change.
-			JobSystem* system = thread->GetUserdata().System;
-			if (system->GetNextJob(job))
+			// Jobs pinned to this worker come first, they run for the job system they were scheduled on.
+			if (mailbox && TakeMailboxJob(*mailbox, job))
 			{
-				job->Call();
+				jobsSinceTimerCheck += ExecuteJob(*thread, *job->m_jobSystem, job);
 				continue;
 			}
-			Thread::SleepFor(1);
+
+			// Get the user data as the system this thread is assigned to could change. The scope keeps its
+			// job systems from being released while this thread uses them, till the end of the iteration.
+			UserdataScope userdata(*thread);
+			tData = userdata.Get();
+			// A thread lent to an elastic job system works there first and falls back to its own.
+			JobSystem* system = tData.LentSystem;
+			if (system)
+			{
+				ThreadStats::Add(stats.StealsAttempted, 1);
+			}
+			if (system && system->GetNextJob(job))
+			{
+				ThreadStats::Add(stats.StealsSucceeded, 1);
+				if (trace)
+				{
+					trace->Record(TraceEventType::Steal);
+				}
+			}
+			else
+			{
+				system = tData.System;
+				if (!system->GetNextJob(job))
+				{
+					// Idle, fire any due timers and look again before sleeping.
+					bool const firedTimers = system->ServiceTimers();
+					if ((tData.LentSystem && tData.LentSystem->ServiceTimers()) || firedTimers)
+					{
+						continue;
+					}
+
+					std::chrono::steady_clock::time_point const parkStart = std::chrono::steady_clock::now();
+					if (trace)
+					{
+						trace->Record(TraceEventType::ParkBegin);
+					}
+					Thread::SleepFor(1);
+					if (trace)
+					{
+						trace->Record(TraceEventType::ParkEnd);
+					}
+					ThreadStats::Add(stats.ParkCount, 1);
+					ThreadStats::Add(stats.IdleTimeNs, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - parkStart).count());
+					continue;
+				}
+			}
+
+			jobsSinceTimerCheck += ExecuteJob(*thread, *system, job);
+
+			// Busy workers never go idle, so check timers every few jobs too.
+			if (jobsSinceTimerCheck >= c_JobsBetweenChecks)
+			{
+				jobsSinceTimerCheck = 0;
+				system->ServiceTimers();
+			}
 		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,201 @@
+#include "MappedFile.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Insight::JS
+{
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(std::string const& path)
+	{
+		Close();
+
+#ifdef _WIN32
+		HANDLE fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (fileHandle == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(fileHandle, &fileSize))
+		{
+			CloseHandle(fileHandle);
+			return false;
+		}
+
+		m_fileHandle = fileHandle;
+		m_size = static_cast<uint64_t>(fileSize.QuadPart);
+		m_isOpen = true;
+		if (m_size == 0)
+		{
+			// Empty files can not be mapped.
+			return true;
+		}
+
+		HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mappingHandle)
+		{
+			Close();
+			return false;
+		}
+		m_mappingHandle = mappingHandle;
+
+		m_data = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+		if (!m_data)
+		{
+			Close();
+			return false;
+		}
+#else
+		m_fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (m_fd < 0)
+		{
+			return false;
+		}
+
+		struct stat fileStat;
+		if (fstat(m_fd, &fileStat) != 0)
+		{
+			Close();
+			return false;
+		}
+
+		m_size = static_cast<uint64_t>(fileStat.st_size);
+		m_isOpen = true;
+		if (m_size == 0)
+		{
+			// Empty files can not be mapped.
+			return true;
+		}
+
+		void* data = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+		if (data == MAP_FAILED)
+		{
+			Close();
+			return false;
+		}
+		m_data = static_cast<const uint8_t*>(data);
+#endif
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+#ifdef _WIN32
+		if (m_data)
+		{
+			UnmapViewOfFile(m_data);
+		}
+		if (m_mappingHandle)
+		{
+			CloseHandle(m_mappingHandle);
+			m_mappingHandle = nullptr;
+		}
+		if (m_fileHandle)
+		{
+			CloseHandle(m_fileHandle);
+			m_fileHandle = nullptr;
+		}
+#else
+		if (m_data)
+		{
+			munmap(const_cast<uint8_t*>(m_data), m_size);
+		}
+		if (m_fd >= 0)
+		{
+			close(m_fd);
+			m_fd = -1;
+		}
+#endif
+		m_data = nullptr;
+		m_size = 0;
+		m_isOpen = false;
+	}
+
+	void MappedFile::Advise(uint64_t offset, uint64_t size, Advice advice) const
+	{
+		if (!m_data || offset >= m_size)
+		{
+			return;
+		}
+
+		// Advice has to start on a page boundary.
+		uint64_t const pageSize = GetPageSize();
+		uint64_t const alignedOffset = offset - offset % pageSize;
+		size = std::min(size + (offset - alignedOffset), m_size - alignedOffset);
+
+#ifdef _WIN32
+		// PrefetchVirtualMemory would need Windows 8 as the minimum target, rely on FILE_FLAG_SEQUENTIAL_SCAN instead.
+#else
+		int posixAdvice = MADV_NORMAL;
+		switch (advice)
+		{
+			case Advice::Normal:		posixAdvice = MADV_NORMAL; break;
+			case Advice::Sequential:	posixAdvice = MADV_SEQUENTIAL; break;
+			case Advice::WillNeed:		posixAdvice = MADV_WILLNEED; break;
+			case Advice::DontNeed:		posixAdvice = MADV_DONTNEED; break;
+		}
+		madvise(const_cast<uint8_t*>(m_data) + alignedOffset, static_cast<size_t>(size), posixAdvice);
+#endif
+	}
+
+	uint64_t MappedFile::GetPageSize()
+	{
+#ifdef _WIN32
+		SYSTEM_INFO systemInfo;
+		GetSystemInfo(&systemInfo);
+		// Views have to start on the allocation granularity, not just the page size.
+		return static_cast<uint64_t>(systemInfo.dwAllocationGranularity);
+#else
+		return static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+	}
+
+	std::vector<MappedFileChunk> SplitMappedFile(MappedFile const& file, MappedFileChunkOptions const& options)
+	{
+		std::vector<MappedFileChunk> chunks;
+		uint64_t const fileSize = file.GetSize();
+		if (!file.GetData() || fileSize == 0)
+		{
+			return chunks;
+		}
+
+		uint64_t const pageSize = MappedFile::GetPageSize();
+		uint64_t const chunkSize = std::max<uint64_t>((options.ChunkSize + pageSize - 1) / pageSize, 1) * pageSize;
+		const uint8_t* data = file.GetData();
+
+		uint64_t chunkBegin = 0;
+		while (chunkBegin < fileSize)
+		{
+			uint64_t chunkEnd = std::min(chunkBegin + chunkSize, fileSize);
+			if (options.SplitOnDelimiter && chunkEnd < fileSize)
+			{
+				// Keep whole records together, the end moves to just after the next delimiter.
+				const uint8_t* delimiter = std::find(data + chunkEnd - 1, data + fileSize, static_cast<uint8_t>(options.Delimiter));
+				chunkEnd = delimiter == data + fileSize ? fileSize : static_cast<uint64_t>(delimiter - data) + 1;
+			}
+
+			MappedFileChunk chunk;
+			chunk.Data = data + chunkBegin;
+			chunk.Offset = chunkBegin;
+			chunk.Size = chunkEnd - chunkBegin;
+			chunk.Index = static_cast<uint32_t>(chunks.size());
+			chunks.push_back(chunk);
+			chunkBegin = chunkEnd;
+		}
+		return chunks;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include "PerfCounters.h"
+#include <atomic>
+#include <iostream>
+#if defined(JS_ENABLE_PERF_COUNTERS) && defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Insight::JS
+{
+	static thread_local PerfCounters* s_currentPerfCounters = nullptr;
+
+	PerfCounters::~PerfCounters()
+	{
+		Close();
+	}
+
+	void PerfCounters::Close()
+	{
+#if defined(JS_ENABLE_PERF_COUNTERS) && defined(__linux__)
+		for (int& fd : m_fds)
+		{
+			if (fd >= 0)
+			{
+				close(fd);
+				fd = -1;
+			}
+		}
+		m_groupFd = -1;
+#endif
+	}
+
+	bool PerfCounters::Open()
+	{
+#if defined(JS_ENABLE_PERF_COUNTERS) && defined(__linux__)
+		if (IsOpen())
+		{
+			return true;
+		}
+
+		const uint64_t configs[c_NumCounters] =
+		{
+			PERF_COUNT_HW_CPU_CYCLES,
+			PERF_COUNT_HW_INSTRUCTIONS,
+			PERF_COUNT_HW_CACHE_MISSES,
+			PERF_COUNT_HW_BRANCH_MISSES,
+		};
+		for (uint32_t i = 0; i < c_NumCounters; ++i)
+		{
+			perf_event_attr attr;
+			std::memset(&attr, 0, sizeof(attr));
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.size = sizeof(attr);
+			attr.config = configs[i];
+			attr.disabled = i == 0 ? 1 : 0;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+			attr.read_format = PERF_FORMAT_GROUP;
+
+			// pid 0 / cpu -1: count the calling thread on whichever CPU it runs. All counters form one group
+			// so they are scheduled onto the PMU together and read with a single read().
+			m_fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : m_fds[0], 0));
+			if (m_fds[i] < 0)
+			{
+				int const error = errno;
+				Close();
+				// Every worker fails the same way, only report it once.
+				static std::atomic_bool s_reported = false;
+				if (!s_reported.exchange(true))
+				{
+					std::cout << "[PerfCounters::Open] perf_event_open failed (" << std::strerror(error) << "), hardware counters are disabled." << '\n';
+				}
+				return false;
+			}
+		}
+		m_groupFd = m_fds[0];
+		ioctl(m_groupFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(m_groupFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	bool PerfCounters::Read([[maybe_unused]] PerfCounterValues& values) const
+	{
+#if defined(JS_ENABLE_PERF_COUNTERS) && defined(__linux__)
+		// PERF_FORMAT_GROUP layout: number of counters followed by each counter's value.
+		uint64_t data[1 + c_NumCounters];
+		if (!IsOpen() || read(m_groupFd, data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)))
+		{
+			return false;
+		}
+		values.Cycles = data[1];
+		values.Instructions = data[2];
+		values.CacheMisses = data[3];
+		values.BranchMisses = data[4];
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void PerfCounters::AddJob(const char* name, PerfCounterValues const& start, PerfCounterValues const& end, PerfCounterValues const& measuredAtStart)
+	{
+		// Jobs run inside this one while it waited (RunPendingJob) have been counted for themselves, leave them out.
+		// The counters are read as a group, but clamp anyway instead of wrapping around.
+		auto exclusive = [](uint64_t total, uint64_t nested) { return total > nested ? total - nested : 0; };
+		PerfCounterValues delta;
+		delta.Jobs = 1;
+		delta.Cycles = exclusive(end.Cycles - start.Cycles, m_measured.Cycles - measuredAtStart.Cycles);
+		delta.Instructions = exclusive(end.Instructions - start.Instructions, m_measured.Instructions - measuredAtStart.Instructions);
+		delta.CacheMisses = exclusive(end.CacheMisses - start.CacheMisses, m_measured.CacheMisses - measuredAtStart.CacheMisses);
+		delta.BranchMisses = exclusive(end.BranchMisses - start.BranchMisses, m_measured.BranchMisses - measuredAtStart.BranchMisses);
+		m_measured += delta;
+
+		std::lock_guard lock(m_totalsMutex);
+		m_totals[name] += delta;
+	}
+
+	void PerfCounters::AddTo(std::map<std::string, PerfCounterValues>& totals) const
+	{
+		std::lock_guard lock(m_totalsMutex);
+		for (auto const& [name, values] : m_totals)
+		{
+			totals[name ? name : "Job"] += values;
+		}
+	}
+
+	PerfCounters* PerfCounters::GetCurrent()
+	{
+		return s_currentPerfCounters;
+	}
+
+	void PerfCounters::SetCurrent(PerfCounters* counters)
+	{
+		s_currentPerfCounters = counters;
+	}
+}
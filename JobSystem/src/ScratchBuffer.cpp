@@ -0,0 +1,95 @@
+#include "ScratchBuffer.h"
+#include <algorithm>
+#include <new>
+#include <utility>
+
+namespace Insight::JS
+{
+	static constexpr std::align_val_t c_ScratchAlignment = std::align_val_t(64);
+	static constexpr uint32_t c_MaxCachedScratchBuffers = 8;
+
+	struct ScratchCache
+	{
+		void* Data[c_MaxCachedScratchBuffers] = { };
+		size_t Sizes[c_MaxCachedScratchBuffers] = { };
+		uint32_t Count = 0;
+
+		~ScratchCache()
+		{
+			Clear();
+		}
+
+		void Clear()
+		{
+			for (uint32_t i = 0; i < Count; ++i)
+			{
+				::operator delete(Data[i], c_ScratchAlignment);
+			}
+			Count = 0;
+		}
+	};
+
+	// Buffers freed on a different thread than they were taken on move to that thread's cache.
+	static thread_local ScratchCache t_scratchCache;
+
+	ScratchBuffer::ScratchBuffer(size_t bytes)
+	{
+		// The smallest cached buffer which fits.
+		ScratchCache& cache = t_scratchCache;
+		uint32_t best = cache.Count;
+		for (uint32_t i = 0; i < cache.Count; ++i)
+		{
+			if (cache.Sizes[i] >= bytes && (best == cache.Count || cache.Sizes[i] < cache.Sizes[best]))
+			{
+				best = i;
+			}
+		}
+		if (best < cache.Count)
+		{
+			m_data = cache.Data[best];
+			m_size = cache.Sizes[best];
+			--cache.Count;
+			cache.Data[best] = cache.Data[cache.Count];
+			cache.Sizes[best] = cache.Sizes[cache.Count];
+			return;
+		}
+
+		// Round up so a slowly growing size doesn't allocate every time.
+		m_size = std::max<size_t>(bytes, 4096);
+		m_size = (m_size + m_size / 4 + 63) & ~size_t(63);
+		m_data = ::operator new(m_size, c_ScratchAlignment);
+	}
+
+	ScratchBuffer::~ScratchBuffer()
+	{
+		ScratchCache& cache = t_scratchCache;
+		if (cache.Count < c_MaxCachedScratchBuffers)
+		{
+			cache.Data[cache.Count] = m_data;
+			cache.Sizes[cache.Count] = m_size;
+			++cache.Count;
+			return;
+		}
+
+		// Full, keep the bigger buffer.
+		uint32_t smallest = 0;
+		for (uint32_t i = 1; i < cache.Count; ++i)
+		{
+			if (cache.Sizes[i] < cache.Sizes[smallest])
+			{
+				smallest = i;
+			}
+		}
+		if (cache.Sizes[smallest] < m_size)
+		{
+			std::swap(cache.Data[smallest], m_data);
+			std::swap(cache.Sizes[smallest], m_size);
+		}
+		::operator delete(m_data, c_ScratchAlignment);
+	}
+
+	void ScratchBuffer::ReleaseCache()
+	{
+		t_scratchCache.Clear();
+	}
+}
@@ -0,0 +1,76 @@
+#include "Task.h"
+#include <new>
+
+namespace Insight::JS
+{
+	// Frames are rounded up to 64 bytes. Bigger frames than the largest size class use the heap.
+	static constexpr size_t c_FrameSizeClassBytes = 64;
+	static constexpr size_t c_FrameSizeClassCount = 32;
+	static constexpr uint32_t c_MaxCachedFramesPerClass = 256;
+
+	struct FreeFrame
+	{
+		FreeFrame* Next = nullptr;
+	};
+
+	struct FrameCache
+	{
+		FreeFrame* FreeLists[c_FrameSizeClassCount] = { };
+		uint32_t FreeCounts[c_FrameSizeClassCount] = { };
+
+		~FrameCache()
+		{
+			for (FreeFrame* frame : FreeLists)
+			{
+				while (frame)
+				{
+					FreeFrame* next = frame->Next;
+					::operator delete(frame);
+					frame = next;
+				}
+			}
+		}
+	};
+
+	// Frames freed on a different thread than they were allocated on move to that thread's cache.
+	static thread_local FrameCache t_frameCache;
+
+	static size_t GetSizeClass(size_t size)
+	{
+		return (size + c_FrameSizeClassBytes - 1) / c_FrameSizeClassBytes - 1;
+	}
+
+	void* CoroutineFrameAllocator::Allocate(size_t size)
+	{
+		size_t const sizeClass = GetSizeClass(size);
+		if (sizeClass >= c_FrameSizeClassCount)
+		{
+			return ::operator new(size);
+		}
+
+		FreeFrame*& freeList = t_frameCache.FreeLists[sizeClass];
+		if (freeList)
+		{
+			FreeFrame* frame = freeList;
+			freeList = frame->Next;
+			--t_frameCache.FreeCounts[sizeClass];
+			return frame;
+		}
+		return ::operator new((sizeClass + 1) * c_FrameSizeClassBytes);
+	}
+
+	void CoroutineFrameAllocator::Free(void* ptr, size_t size)
+	{
+		size_t const sizeClass = GetSizeClass(size);
+		if (sizeClass >= c_FrameSizeClassCount || t_frameCache.FreeCounts[sizeClass] >= c_MaxCachedFramesPerClass)
+		{
+			::operator delete(ptr);
+			return;
+		}
+
+		FreeFrame* frame = new (ptr) FreeFrame();
+		frame->Next = t_frameCache.FreeLists[sizeClass];
+		t_frameCache.FreeLists[sizeClass] = frame;
+		++t_frameCache.FreeCounts[sizeClass];
+	}
+}
\ No newline at end of file
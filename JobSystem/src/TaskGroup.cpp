@@ -0,0 +1,65 @@
+#include "TaskGroup.h"
+#include "Thread.h"
+#include "Trace.h"
+
+namespace Insight::JS
+{
+	TaskGroup::TaskGroup(JobSystem& jobSystem, JobPriority priority)
+		: m_jobSystem(jobSystem)
+		, m_priority(priority)
+	{ }
+
+	TaskGroup::~TaskGroup()
+	{
+		Join();
+	}
+
+	void TaskGroup::Wait()
+	{
+		Join();
+
+		std::exception_ptr exception = std::move(m_exception);
+		m_exception = nullptr;
+		m_hasException.store(false, std::memory_order_relaxed);
+		m_canceled.store(false, std::memory_order_relaxed);
+		if (exception)
+		{
+			std::rethrow_exception(exception);
+		}
+	}
+
+	void TaskGroup::SetException(std::exception_ptr exception)
+	{
+		if (!m_hasException.exchange(true, std::memory_order_acq_rel))
+		{
+			// Published to 'Wait' by the job's decrement of 'm_pendingJobs'.
+			m_exception = std::move(exception);
+			Cancel();
+		}
+	}
+
+	void TaskGroup::Join()
+	{
+		if (GetPendingJobsCount() == 0)
+		{
+			return;
+		}
+
+		TraceBuffer* trace = TraceBuffer::GetCurrent();
+		if (trace)
+		{
+			trace->Record(TraceEventType::WaitBegin);
+		}
+		while (GetPendingJobsCount() > 0)
+		{
+			if (!JobSystemManager::RunPendingJob())
+			{
+				std::this_thread::yield();
+			}
+		}
+		if (trace)
+		{
+			trace->Record(TraceEventType::WaitEnd);
+		}
+	}
+}
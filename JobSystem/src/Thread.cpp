@@ -8,9 +8,13 @@
 
 namespace Insight::JS
 {
+	static thread_local Thread* s_currentThread = nullptr;
+
 	static void LaunchThread(void* ptr)
 	{
 		auto thread = reinterpret_cast<Thread*>(ptr);
+		s_currentThread = thread;
+		TraceBuffer::SetCurrent(thread->GetTraceBuffer());
 		auto callback = thread->GetCallback();
 
 		if (callback == nullptr)
@@ -37,6 +41,53 @@ namespace Insight::JS
 		}
 	}
 
+	void Thread::SetLentSystem(JobSystem* system)
+	{
+		{
+			std::lock_guard lock(m_userDataMutex);
+			m_userData.LentSystem = system;
+		}
+	}
+
+	ThreadData Thread::EnterUserdata()
+	{
+		// Bumped before the data is read, so 'ReleaseJobSystem' moving the thread off a job system and then
+		// seeing an even epoch means this read can't have returned that job system.
+		if (m_userdataDepth++ == 0)
+		{
+			m_userdataEpoch.fetch_add(1, std::memory_order_seq_cst);
+		}
+		return GetUserdata();
+	}
+
+	void Thread::LeaveUserdata()
+	{
+		if (--m_userdataDepth == 0)
+		{
+			m_userdataEpoch.fetch_add(1, std::memory_order_seq_cst);
+		}
+	}
+
+	void Thread::WaitForUserdataUsers() const
+	{
+		// A busy thread enters again straight after leaving, wait for the epoch to move instead of for it to be out.
+		uint64_t const epoch = m_userdataEpoch.load(std::memory_order_seq_cst);
+		while (epoch % 2 == 1 && m_userdataEpoch.load(std::memory_order_seq_cst) == epoch)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	void Thread::EnableTracing(uint32_t capacity)
+	{
+		m_traceBuffer = std::make_unique<TraceBuffer>(capacity);
+	}
+
+	void Thread::EnableLatencyHistograms()
+	{
+		m_latencyHistograms = std::make_unique<JobLatencyHistograms>();
+	}
+
 	void Thread::SetAffinity(size_t i)
 	{
 		if (!HasSpawned())
@@ -76,4 +127,9 @@ namespace Insight::JS
 	{
 		std::this_thread::sleep_for(std::chrono::milliseconds(ms));
 	}
+
+	Thread* Thread::GetCurrent()
+	{
+		return s_currentThread;
+	}
 }
\ No newline at end of file
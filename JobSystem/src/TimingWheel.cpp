@@ -0,0 +1,213 @@
+#include "TimingWheel.h"
+#include <algorithm>
+
+namespace Insight::JS
+{
+	TimingWheel::TimingWheel()
+		: m_startNs(TraceClock::NowNanoseconds())
+	{
+		m_slots.fill(c_None);
+	}
+
+	TimerHandle TimingWheel::Add(JobSharedPtr const& job, uint64_t expiryNs)
+	{
+		std::lock_guard lock(m_mutex);
+		if (m_pendingCount.load(std::memory_order_relaxed) == 0)
+		{
+			// Nothing is pending so the wheel may not have been advanced for a while, catch it up for free.
+			m_currentTick = std::max(m_currentTick, ToTick(TraceClock::NowNanoseconds()));
+		}
+
+		uint32_t index;
+		if (m_freeEntries.empty())
+		{
+			index = static_cast<uint32_t>(m_entries.size());
+			m_entries.emplace_back();
+		}
+		else
+		{
+			index = m_freeEntries.back();
+			m_freeEntries.pop_back();
+		}
+
+		Entry& entry = m_entries[index];
+		entry.Job = job;
+		entry.ExpiryTick = ToTick(expiryNs);
+		Link(index);
+		m_pendingCount.fetch_add(1, std::memory_order_release);
+		return TimerHandle{ this, index, entry.Generation };
+	}
+
+	JobSharedPtr TimingWheel::Cancel(TimerHandle const& handle)
+	{
+		std::lock_guard lock(m_mutex);
+		if (handle.Wheel != this || handle.Index >= m_entries.size())
+		{
+			return nullptr;
+		}
+		Entry& entry = m_entries[handle.Index];
+		if (entry.Generation != handle.Generation || entry.Slot == c_None)
+		{
+			return nullptr;
+		}
+
+		JobSharedPtr job = std::move(entry.Job);
+		Unlink(handle.Index);
+		Free(handle.Index);
+		m_pendingCount.fetch_sub(1, std::memory_order_release);
+		return job;
+	}
+
+	void TimingWheel::Clear(std::vector<JobSharedPtr>& jobs)
+	{
+		std::lock_guard lock(m_mutex);
+		for (uint32_t i = 0; i < m_entries.size(); ++i)
+		{
+			if (m_entries[i].Slot != c_None)
+			{
+				jobs.push_back(std::move(m_entries[i].Job));
+				Free(i);
+			}
+		}
+		m_slots.fill(c_None);
+		m_pendingCount.store(0, std::memory_order_release);
+	}
+
+	bool TimingWheel::TryAdvance(uint64_t nowNs, std::vector<JobSharedPtr>& expired)
+	{
+		std::unique_lock lock(m_mutex, std::try_to_lock);
+		if (!lock.owns_lock())
+		{
+			return false;
+		}
+
+		// Timers are rounded up to the next tick, so every tick up to and including 'now' has expired.
+		uint64_t const nowTick = nowNs <= m_startNs ? 0 : (nowNs - m_startNs) / c_TickNs;
+		while (m_currentTick <= nowTick)
+		{
+			if (m_pendingCount.load(std::memory_order_relaxed) == 0)
+			{
+				m_currentTick = nowTick + 1;
+				break;
+			}
+
+			// Level 0 wrapped, pull the next slot of each higher level down.
+			uint32_t const slot = static_cast<uint32_t>(m_currentTick & c_SlotMask);
+			if (slot == 0)
+			{
+				for (uint32_t level = 1; level < c_Levels; ++level)
+				{
+					Cascade(level);
+					if (((m_currentTick >> (level * c_SlotBits)) & c_SlotMask) != 0)
+					{
+						break;
+					}
+				}
+			}
+
+			uint32_t index = m_slots[slot];
+			m_slots[slot] = c_None;
+			while (index != c_None)
+			{
+				Entry& entry = m_entries[index];
+				uint32_t const next = entry.Next;
+				entry.Slot = c_None;
+				if (entry.ExpiryTick <= m_currentTick)
+				{
+					expired.push_back(std::move(entry.Job));
+					Free(index);
+					m_pendingCount.fetch_sub(1, std::memory_order_release);
+				}
+				else
+				{
+					// Beyond the wheel's range when it was added.
+					Link(index);
+				}
+				index = next;
+			}
+			++m_currentTick;
+		}
+		return true;
+	}
+
+	uint64_t TimingWheel::ToTick(uint64_t ns) const
+	{
+		return ns <= m_startNs ? 0 : (ns - m_startNs + c_TickNs - 1) / c_TickNs;
+	}
+
+	void TimingWheel::Link(uint32_t index)
+	{
+		Entry& entry = m_entries[index];
+		uint64_t const expiryTick = std::max(entry.ExpiryTick, m_currentTick);
+		uint64_t const delta = expiryTick - m_currentTick;
+
+		uint32_t slot = 0;
+		uint32_t level = 0;
+		for (; level < c_Levels; ++level)
+		{
+			if (delta < (1ull << ((level + 1) * c_SlotBits)))
+			{
+				slot = static_cast<uint32_t>((expiryTick >> (level * c_SlotBits)) & c_SlotMask);
+				break;
+			}
+		}
+		if (level == c_Levels)
+		{
+			// Park it in the furthest slot, it is re-linked when that slot cascades.
+			level = c_Levels - 1;
+			uint64_t const furthestTick = m_currentTick + (1ull << (c_Levels * c_SlotBits)) - 1;
+			slot = static_cast<uint32_t>((furthestTick >> (level * c_SlotBits)) & c_SlotMask);
+		}
+
+		entry.Slot = level * c_Slots + slot;
+		entry.Prev = c_None;
+		entry.Next = m_slots[entry.Slot];
+		if (entry.Next != c_None)
+		{
+			m_entries[entry.Next].Prev = index;
+		}
+		m_slots[entry.Slot] = index;
+	}
+
+	void TimingWheel::Unlink(uint32_t index)
+	{
+		Entry& entry = m_entries[index];
+		if (entry.Prev != c_None)
+		{
+			m_entries[entry.Prev].Next = entry.Next;
+		}
+		else
+		{
+			m_slots[entry.Slot] = entry.Next;
+		}
+		if (entry.Next != c_None)
+		{
+			m_entries[entry.Next].Prev = entry.Prev;
+		}
+		entry.Slot = c_None;
+	}
+
+	void TimingWheel::Free(uint32_t index)
+	{
+		Entry& entry = m_entries[index];
+		entry.Job.reset();
+		entry.Slot = c_None;
+		entry.Prev = c_None;
+		entry.Next = c_None;
+		++entry.Generation;
+		m_freeEntries.push_back(index);
+	}
+
+	void TimingWheel::Cascade(uint32_t level)
+	{
+		uint32_t const slot = level * c_Slots + static_cast<uint32_t>((m_currentTick >> (level * c_SlotBits)) & c_SlotMask);
+		uint32_t index = m_slots[slot];
+		m_slots[slot] = c_None;
+		while (index != c_None)
+		{
+			uint32_t const next = m_entries[index].Next;
+			Link(index);
+			index = next;
+		}
+	}
+}
@@ -0,0 +1,171 @@
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace Insight::JS
+{
+	static thread_local TraceBuffer* s_currentTraceBuffer = nullptr;
+
+	uint64_t TraceClock::Now()
+	{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return NowNanoseconds();
+#endif
+	}
+
+	uint64_t TraceClock::NowNanoseconds()
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	TraceClockCalibration TraceClockCalibration::Capture()
+	{
+		TraceClockCalibration calibration;
+		calibration.Ticks = TraceClock::Now();
+		calibration.Nanoseconds = TraceClock::NowNanoseconds();
+		return calibration;
+	}
+
+	TraceBuffer::TraceBuffer(uint32_t capacity)
+	{
+		uint64_t size = 1;
+		while (size < capacity)
+		{
+			size <<= 1;
+		}
+		m_events = std::make_unique<TraceEvent[]>(size);
+		m_mask = size - 1;
+	}
+
+	void TraceBuffer::Read(std::vector<TraceEvent>& events) const
+	{
+		uint64_t const capacity = m_mask + 1;
+		uint64_t const end = m_writeIndex.load(std::memory_order_acquire);
+		uint64_t begin = end > capacity ? end - capacity : 0;
+
+		size_t const firstEvent = events.size();
+		for (uint64_t i = begin; i < end; ++i)
+		{
+			events.push_back(m_events[i & m_mask]);
+		}
+
+		// Drop events the owner overwrote while they were copied, including a slot it may be writing now.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t const writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+		if (writeIndex >= capacity && writeIndex - capacity + 1 > begin)
+		{
+			uint64_t const overwritten = std::min(writeIndex - capacity + 1, end) - begin;
+			events.erase(events.begin() + firstEvent, events.begin() + firstEvent + overwritten);
+		}
+	}
+
+	TraceBuffer* TraceBuffer::GetCurrent()
+	{
+		return s_currentTraceBuffer;
+	}
+
+	void TraceBuffer::SetCurrent(TraceBuffer* buffer)
+	{
+		s_currentTraceBuffer = buffer;
+	}
+
+	static void WriteJsonString(std::ostream& stream, const char* string)
+	{
+		stream << '"';
+		for (const char* c = string; *c != '\0'; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				stream << '\\';
+			}
+			if (static_cast<unsigned char>(*c) >= 0x20)
+			{
+				stream << *c;
+			}
+		}
+		stream << '"';
+	}
+
+	void WriteChromeTrace(std::ostream& stream, std::vector<TraceThread> const& threads, TraceClockCalibration const& start)
+	{
+		TraceClockCalibration const now = TraceClockCalibration::Capture();
+		double const elapsedMicroseconds = static_cast<double>(now.Nanoseconds - start.Nanoseconds) / 1000.0;
+		double const ticksPerMicrosecond = elapsedMicroseconds > 0.0 ? static_cast<double>(now.Ticks - start.Ticks) / elapsedMicroseconds : 1.0;
+
+		// Timestamps are written with std::fixed, the caller's formatting is restored at the end.
+		std::ios_base::fmtflags const streamFlags = stream.flags();
+		stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+		bool first = true;
+		auto beginEvent = [&stream, &first](const char* phase, uint64_t threadId)
+		{
+			stream << (first ? "\n" : ",\n") << "{\"pid\":0,\"tid\":" << threadId << ",\"ph\":\"" << phase << '"';
+			first = false;
+		};
+
+		for (uint64_t threadId = 0; threadId < threads.size(); ++threadId)
+		{
+			TraceThread const& thread = threads[threadId];
+			beginEvent("M", threadId);
+			stream << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+			WriteJsonString(stream, thread.Name.c_str());
+			stream << "}}";
+
+			// Begin events whose end has not been seen yet. Ends whose begin was overwritten are dropped.
+			std::vector<TraceEventType> openEvents;
+			for (TraceEvent const& event : thread.Events)
+			{
+				const char* phase = "B";
+				const char* name = nullptr;
+				switch (event.Type)
+				{
+					case TraceEventType::JobBegin:	name = event.Name ? event.Name : "Job"; break;
+					case TraceEventType::WaitBegin:	name = "Wait"; break;
+					case TraceEventType::ParkBegin:	name = "Park"; break;
+					case TraceEventType::Steal:		name = "Steal"; phase = "i"; break;
+					case TraceEventType::JobEnd:
+					case TraceEventType::WaitEnd:
+					case TraceEventType::ParkEnd:
+						phase = "E";
+						break;
+				}
+
+				if (event.Type == TraceEventType::JobBegin || event.Type == TraceEventType::WaitBegin || event.Type == TraceEventType::ParkBegin)
+				{
+					openEvents.push_back(event.Type);
+				}
+				else if (phase[0] == 'E')
+				{
+					TraceEventType const beginType = static_cast<TraceEventType>(static_cast<uint8_t>(event.Type) - 1);
+					if (openEvents.empty() || openEvents.back() != beginType)
+					{
+						continue;
+					}
+					openEvents.pop_back();
+				}
+
+				double const timestamp = (static_cast<double>(event.Timestamp) - static_cast<double>(start.Ticks)) / ticksPerMicrosecond;
+				beginEvent(phase, threadId);
+				stream << ",\"ts\":" << std::fixed << timestamp;
+				if (name)
+				{
+					stream << ",\"name\":";
+					WriteJsonString(stream, name);
+				}
+				if (phase[0] == 'i')
+				{
+					stream << ",\"s\":\"t\"";
+				}
+				stream << '}';
+			}
+		}
+		stream << "\n]}\n";
+		stream.flags(streamFlags);
+	}
+}
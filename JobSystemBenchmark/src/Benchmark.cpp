@@ -0,0 +1,278 @@
+#include "Benchmark.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <iomanip>
+
+namespace Insight::JS::Bench
+{
+	std::vector<BenchmarkDefinition>& GetBenchmarks()
+	{
+		static std::vector<BenchmarkDefinition> benchmarks;
+		return benchmarks;
+	}
+
+	BenchmarkRegistration::BenchmarkRegistration(const char* name, BenchmarkFunc func, std::vector<int64_t> args, bool sweepPriorities)
+	{
+		BenchmarkDefinition definition;
+		definition.Name = name;
+		definition.Func = func;
+		definition.Args = std::move(args);
+		definition.SweepPriorities = sweepPriorities;
+		GetBenchmarks().push_back(std::move(definition));
+	}
+
+	void SpinUntil(std::atomic<uint64_t> const& counter, uint64_t target)
+	{
+		while (counter.load(std::memory_order_acquire) < target)
+		{ }
+	}
+
+	struct BenchmarkOptions
+	{
+		std::vector<uint32_t> ThreadCounts;
+		std::string Filter;
+		std::string JsonPath;
+		double MinTimeSeconds = 0.2;
+	};
+
+	struct BenchmarkResult
+	{
+		std::string Name;
+		uint32_t NumThreads = 0;
+		JobPriority Priority = JobPriority::Normal;
+		int64_t Arg = 0;
+		uint64_t Iterations = 0;
+		double NanosecondsPerIteration = 0.0;
+		double ItemsPerSecond = 0.0;
+		std::map<std::string, double> Counters;
+	};
+
+	static const char* ToString(JobPriority priority)
+	{
+		switch (priority)
+		{
+			case JobPriority::High:		return "High";
+			case JobPriority::Normal:	return "Normal";
+			case JobPriority::Low:		return "Low";
+		}
+		return "Unknown";
+	}
+
+	static std::string GetFullName(BenchmarkResult const& result, bool hasArg)
+	{
+		std::ostringstream name;
+		name << result.Name;
+		if (hasArg)
+		{
+			name << '/' << result.Arg;
+		}
+		name << "/threads:" << result.NumThreads << "/priority:" << ToString(result.Priority);
+		return name.str();
+	}
+
+	static double Percentile(std::vector<double>& samples, double percentile)
+	{
+		std::sort(samples.begin(), samples.end());
+		size_t const index = static_cast<size_t>(std::ceil(percentile / 100.0 * samples.size()));
+		return samples[std::min(index == 0 ? 0 : index - 1, samples.size() - 1)];
+	}
+
+	static BenchmarkResult RunBenchmark(BenchmarkDefinition const& definition, JobSystemManager& manager, uint32_t numThreads,
+										JobPriority priority, int64_t arg, double minTimeSeconds)
+	{
+		// Grow the iteration count until a run takes at least 'minTimeSeconds', like Google Benchmark does.
+		uint64_t iterations = 1;
+		while (true)
+		{
+			BenchmarkState state(manager, numThreads, priority, arg, iterations);
+			definition.Func(state);
+
+			double const seconds = std::chrono::duration<double>(state.GetElapsed()).count();
+			if (seconds >= minTimeSeconds || iterations >= 1000000000ull)
+			{
+				BenchmarkResult result;
+				result.Name = definition.Name;
+				result.NumThreads = numThreads;
+				result.Priority = priority;
+				result.Arg = arg;
+				result.Iterations = iterations;
+				result.NanosecondsPerIteration = seconds * 1e9 / static_cast<double>(iterations);
+				result.ItemsPerSecond = seconds > 0.0 ? static_cast<double>(state.GetItemsProcessed()) / seconds : 0.0;
+				result.Counters = state.GetCounters();
+				std::vector<double>& samples = state.GetSamples();
+				if (!samples.empty())
+				{
+					result.Counters["p50_ns"] = Percentile(samples, 50.0);
+					result.Counters["p99_ns"] = Percentile(samples, 99.0);
+					result.Counters["p999_ns"] = Percentile(samples, 99.9);
+					result.Counters["max_ns"] = samples.back();
+				}
+				return result;
+			}
+
+			double const multiplier = seconds > 0.0 ? std::min(10.0, minTimeSeconds / seconds * 1.4) : 10.0;
+			iterations = std::max<uint64_t>(iterations + 1, static_cast<uint64_t>(iterations * multiplier));
+		}
+	}
+
+	static void WriteJson(std::ostream& stream, std::vector<std::pair<BenchmarkResult, bool>> const& results)
+	{
+		stream << "{\n  \"context\": {\n";
+		stream << "    \"hardware_concurrency\": " << std::thread::hardware_concurrency() << "\n";
+		stream << "  },\n  \"benchmarks\": [\n";
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			BenchmarkResult const& result = results[i].first;
+			stream << "    {\n";
+			stream << "      \"name\": \"" << GetFullName(result, results[i].second) << "\",\n";
+			stream << "      \"run_name\": \"" << result.Name << "\",\n";
+			stream << "      \"threads\": " << result.NumThreads << ",\n";
+			stream << "      \"priority\": \"" << ToString(result.Priority) << "\",\n";
+			stream << "      \"arg\": " << result.Arg << ",\n";
+			stream << "      \"iterations\": " << result.Iterations << ",\n";
+			stream << "      \"real_time\": " << result.NanosecondsPerIteration << ",\n";
+			stream << "      \"time_unit\": \"ns\",\n";
+			stream << "      \"items_per_second\": " << result.ItemsPerSecond;
+			for (auto const& [name, value] : result.Counters)
+			{
+				stream << ",\n      \"" << name << "\": " << value;
+			}
+			stream << "\n    }" << (i + 1 < results.size() ? "," : "") << "\n";
+		}
+		stream << "  ]\n}\n";
+	}
+
+	static bool ParseOptions(int argc, char** argv, BenchmarkOptions& options)
+	{
+		uint32_t maxThreads = std::thread::hardware_concurrency();
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string const arg = argv[i];
+			auto value = [&arg](const char* prefix) { return arg.substr(std::strlen(prefix)); };
+			if (arg.rfind("--filter=", 0) == 0)
+			{
+				options.Filter = value("--filter=");
+			}
+			else if (arg.rfind("--json=", 0) == 0)
+			{
+				options.JsonPath = value("--json=");
+			}
+			else if (arg.rfind("--min-time=", 0) == 0)
+			{
+				options.MinTimeSeconds = std::stod(value("--min-time="));
+			}
+			else if (arg.rfind("--max-threads=", 0) == 0)
+			{
+				maxThreads = static_cast<uint32_t>(std::stoul(value("--max-threads=")));
+			}
+			else if (arg.rfind("--threads=", 0) == 0)
+			{
+				std::stringstream list(value("--threads="));
+				std::string count;
+				while (std::getline(list, count, ','))
+				{
+					options.ThreadCounts.push_back(static_cast<uint32_t>(std::stoul(count)));
+				}
+			}
+			else
+			{
+				std::cout << "Usage: " << argv[0] << " [--filter=substring] [--json=file|-] [--min-time=seconds]"
+					<< " [--threads=1,2,4 | --max-threads=N]" << '\n';
+				return false;
+			}
+		}
+
+		if (options.ThreadCounts.empty())
+		{
+			for (uint32_t threads = 1; threads <= std::max(maxThreads, 1u); ++threads)
+			{
+				options.ThreadCounts.push_back(threads);
+			}
+		}
+		return true;
+	}
+
+	static int RunAll(BenchmarkOptions const& options)
+	{
+		std::vector<std::pair<BenchmarkResult, bool>> results;
+		std::cout << std::left << std::setw(64) << "Benchmark" << std::right << std::setw(16) << "Time (ns)"
+			<< std::setw(14) << "Iterations" << std::setw(18) << "Items/s" << '\n';
+
+		for (uint32_t numThreads : options.ThreadCounts)
+		{
+			JobSystemManagerOptions managerOptions;
+			managerOptions.NumThreads = numThreads;
+			managerOptions.ThreadAffinity = false;
+			managerOptions.NumBlockingThreads = 0;
+			managerOptions.AsyncIOQueueDepth = 0;
+
+			// A fresh manager per thread count, so no state leaks between sweeps.
+			std::unique_ptr<JobSystemManager> manager = std::make_unique<JobSystemManager>();
+			if (manager->Init(managerOptions) != JobSystemManager::ReturnCode::Succes)
+			{
+				std::cout << "[RunAll] Failed to start a job system with " << numThreads << " threads, skipping." << '\n';
+				continue;
+			}
+
+			for (BenchmarkDefinition const& definition : GetBenchmarks())
+			{
+				if (!options.Filter.empty() && definition.Name.find(options.Filter) == std::string::npos)
+				{
+					continue;
+				}
+
+				std::vector<JobPriority> priorities = { JobPriority::Normal };
+				if (definition.SweepPriorities)
+				{
+					priorities = { JobPriority::High, JobPriority::Normal, JobPriority::Low };
+				}
+				std::vector<int64_t> args = definition.Args.empty() ? std::vector<int64_t>{ 0 } : definition.Args;
+
+				for (JobPriority priority : priorities)
+				{
+					for (int64_t arg : args)
+					{
+						BenchmarkResult result = RunBenchmark(definition, *manager, numThreads, priority, arg, options.MinTimeSeconds);
+						bool const hasArg = !definition.Args.empty();
+						std::cout << std::left << std::setw(64) << GetFullName(result, hasArg) << std::right << std::setw(16)
+							<< std::fixed << std::setprecision(1) << result.NanosecondsPerIteration << std::setw(14) << result.Iterations
+							<< std::setw(18) << std::setprecision(0) << result.ItemsPerSecond << '\n';
+						results.emplace_back(std::move(result), hasArg);
+					}
+				}
+			}
+			manager->Shutdown(true);
+		}
+
+		if (options.JsonPath == "-")
+		{
+			WriteJson(std::cout, results);
+		}
+		else if (!options.JsonPath.empty())
+		{
+			std::ofstream file(options.JsonPath);
+			if (!file.is_open())
+			{
+				std::cout << "[RunAll] Could not open '" << options.JsonPath << "' for writing." << '\n';
+				return 1;
+			}
+			WriteJson(file, results);
+		}
+		return 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Insight::JS::Bench::BenchmarkOptions options;
+	if (!Insight::JS::Bench::ParseOptions(argc, argv, options))
+	{
+		return 1;
+	}
+	return Insight::JS::Bench::RunAll(options);
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <map>
+#include "JobSystem.h"
+
+#define JS_BENCHMARK_CONCAT_IMPL(a, b) a##b
+#define JS_BENCHMARK_CONCAT(a, b) JS_BENCHMARK_CONCAT_IMPL(a, b)
+
+// JS_BENCHMARK(Func, { args... }, sweepPriorities)
+#define JS_BENCHMARK(func, ...) \
+	static ::Insight::JS::Bench::BenchmarkRegistration JS_BENCHMARK_CONCAT(s_benchmark_, __LINE__)(#func, func, ##__VA_ARGS__)
+// JS_BENCHMARK_NAMED("Name", Func, { args... }, sweepPriorities), for templated functions and grouped names.
+#define JS_BENCHMARK_NAMED(name, func, ...) \
+	static ::Insight::JS::Bench::BenchmarkRegistration JS_BENCHMARK_CONCAT(s_benchmark_, __LINE__)(name, func, ##__VA_ARGS__)
+
+namespace Insight::JS::Bench
+{
+	using Clock = std::chrono::steady_clock;
+
+	/// <summary>
+	/// Passed to every benchmark run. Time the measured code with 'for (auto _ : state)',
+	/// everything outside that loop is setup and is not timed.
+	/// </summary>
+	class BenchmarkState
+	{
+	public:
+		// Loop variable type. Not trivially destructible so 'for (auto _ : state)' does not warn as unused.
+		struct Value
+		{
+			~Value() { }
+		};
+
+		class Iterator
+		{
+		public:
+			Iterator(BenchmarkState* state, uint64_t remaining) : m_state(state), m_remaining(remaining) { }
+			bool operator!=(Iterator const& other) const
+			{
+				if (m_remaining != other.m_remaining)
+				{
+					return true;
+				}
+				m_state->StopTiming();
+				return false;
+			}
+			Iterator& operator++() { --m_remaining; return *this; }
+			Value operator*() const { return Value(); }
+
+		private:
+			BenchmarkState* m_state;
+			uint64_t m_remaining;
+		};
+
+		BenchmarkState(JobSystemManager& manager, uint32_t numThreads, JobPriority priority, int64_t arg, uint64_t iterations)
+			: m_manager(manager), m_numThreads(numThreads), m_priority(priority), m_arg(arg), m_iterations(iterations)
+		{ }
+
+		Iterator begin() { StartTiming(); return Iterator(this, m_iterations); }
+		Iterator end() { return Iterator(this, 0); }
+
+		void PauseTiming() { m_elapsed += Clock::now() - m_start; }
+		void ResumeTiming() { m_start = Clock::now(); }
+
+		// Items (jobs, elements, tasks) processed in total, reported as items per second.
+		void SetItemsProcessed(uint64_t items) { m_itemsProcessed = items; }
+		// One latency measurement in nanoseconds, reported as percentiles.
+		void AddSample(double nanoseconds) { m_samples.push_back(nanoseconds); }
+		void SetCounter(std::string const& name, double value) { m_counters[name] = value; }
+
+		JobSystemManager& GetManager() const { return m_manager; }
+		uint32_t GetNumThreads() const { return m_numThreads; }
+		JobPriority GetPriority() const { return m_priority; }
+		int64_t GetArg() const { return m_arg; }
+		uint64_t GetIterations() const { return m_iterations; }
+
+		Clock::duration GetElapsed() const { return m_elapsed; }
+		uint64_t GetItemsProcessed() const { return m_itemsProcessed; }
+		std::vector<double>& GetSamples() { return m_samples; }
+		std::map<std::string, double> const& GetCounters() const { return m_counters; }
+
+	private:
+		void StartTiming() { m_elapsed = Clock::duration::zero(); m_start = Clock::now(); }
+		void StopTiming() { m_elapsed += Clock::now() - m_start; }
+
+	private:
+		JobSystemManager& m_manager;
+		uint32_t m_numThreads;
+		JobPriority m_priority;
+		int64_t m_arg;
+		uint64_t m_iterations;
+
+		Clock::time_point m_start;
+		Clock::duration m_elapsed = Clock::duration::zero();
+		uint64_t m_itemsProcessed = 0;
+		std::vector<double> m_samples;
+		std::map<std::string, double> m_counters;
+	};
+
+	using BenchmarkFunc = void(*)(BenchmarkState&);
+
+	struct BenchmarkDefinition
+	{
+		std::string Name;
+		BenchmarkFunc Func = nullptr;
+		std::vector<int64_t> Args;		// Each arg is run as its own benchmark, empty = one run with arg 0.
+		bool SweepPriorities = true;	// Run once per JobPriority, otherwise only with JobPriority::Normal.
+	};
+
+	/// <summary>
+	/// Static registration of a benchmark, see 'JS_BENCHMARK'.
+	/// </summary>
+	struct BenchmarkRegistration
+	{
+		BenchmarkRegistration(const char* name, BenchmarkFunc func, std::vector<int64_t> args = { }, bool sweepPriorities = true);
+	};
+
+	std::vector<BenchmarkDefinition>& GetBenchmarks();
+
+	// Wait on an atomic counter reaching 'target', the cheapest join available to benchmarks.
+	void SpinUntil(std::atomic<uint64_t> const& counter, uint64_t target);
+
+	// Keep the compiler from optimising away a value.
+	template<typename T>
+	void DoNotOptimize(T const& value)
+	{
+#if defined(_MSC_VER)
+		static volatile const void* sink;
+		sink = &value;
+#else
+		asm volatile("" : : "r,m"(value) : "memory");
+#endif
+	}
+}
\ No newline at end of file
@@ -0,0 +1,626 @@
+#include "Benchmark.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <random>
+#include <unordered_map>
+
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+#if defined(JS_BENCHMARK_TBB)
+#include <tbb/global_control.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
+#endif
+
+// The same workloads run on JobSystemManager and on reference runtimes. Every run reports its
+// speedup over a single threaded run of the same workload as the 'speedup' counter.
+// OpenMP runs are built with the 'with-openmp' premake option and TBB runs with 'with-tbb'.
+
+namespace Insight::JS::Bench
+{
+	// 'start' is taken before 'serial' is called, workloads which build their input first reset it once the input
+	// is built, so the baseline times the same work as the parallel runs which pause timing around it.
+	using SerialFunc = void(*)(int64_t arg, Clock::time_point& start);
+
+	static double GetSerialNanoseconds(std::string const& key, SerialFunc serial, int64_t arg)
+	{
+		// Median of 3 runs, measured once per workload and size.
+		static std::unordered_map<std::string, double> s_serialTimes;
+		std::string const fullKey = key + "/" + std::to_string(arg);
+		auto itr = s_serialTimes.find(fullKey);
+		if (itr != s_serialTimes.end())
+		{
+			return itr->second;
+		}
+
+		double times[3];
+		for (double& time : times)
+		{
+			Clock::time_point start = Clock::now();
+			serial(arg, start);
+			time = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+		}
+		std::sort(std::begin(times), std::end(times));
+		s_serialTimes[fullKey] = times[1];
+		return times[1];
+	}
+
+	static void SetSpeedup(BenchmarkState& state, std::string const& key, SerialFunc serial)
+	{
+		double const nanosecondsPerIteration = std::chrono::duration<double, std::nano>(state.GetElapsed()).count() / static_cast<double>(state.GetIterations());
+		state.SetCounter("speedup", GetSerialNanoseconds(key, serial, state.GetArg()) / nanosecondsPerIteration);
+	}
+
+	/// <summary>
+	/// Runtimes. Each one provides 'For(count, func)' calling 'func(index)' for [0, count) in parallel.
+	/// </summary>
+	struct JobSystemRuntime
+	{
+		static constexpr const char* Name = "JobSystem";
+		JobSystem& System;
+		uint32_t NumThreads;
+
+		explicit JobSystemRuntime(BenchmarkState& state) : System(state.GetManager().GetMainJobSystem()), NumThreads(state.GetNumThreads()) { }
+
+		template<typename Func>
+		void For(uint64_t count, Func func)
+		{
+			ParallelFor(System, 0, count, std::max<uint64_t>(count / (NumThreads * 4), 1), func);
+		}
+	};
+
+	struct AsyncRuntime
+	{
+		static constexpr const char* Name = "StdAsync";
+		uint32_t NumThreads;
+
+		explicit AsyncRuntime(BenchmarkState& state) : NumThreads(state.GetNumThreads()) { }
+
+		template<typename Func>
+		void For(uint64_t count, Func func)
+		{
+			uint64_t const blockSize = (count + NumThreads - 1) / NumThreads;
+			std::vector<std::future<void>> futures;
+			for (uint64_t begin = 0; begin < count; begin += blockSize)
+			{
+				uint64_t const end = std::min(begin + blockSize, count);
+				futures.push_back(std::async(std::launch::async, [func, begin, end]()
+											 {
+												 for (uint64_t i = begin; i < end; ++i)
+												 {
+													 func(i);
+												 }
+											 }));
+			}
+			for (std::future<void>& future : futures)
+			{
+				future.wait();
+			}
+		}
+	};
+
+#if defined(_OPENMP)
+	struct OpenMPRuntime
+	{
+		static constexpr const char* Name = "OpenMP";
+		uint32_t NumThreads;
+
+		explicit OpenMPRuntime(BenchmarkState& state) : NumThreads(state.GetNumThreads()) { }
+
+		template<typename Func>
+		void For(uint64_t count, Func func)
+		{
+			int64_t const signedCount = static_cast<int64_t>(count);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(NumThreads)
+			for (int64_t i = 0; i < signedCount; ++i)
+			{
+				func(static_cast<uint64_t>(i));
+			}
+		}
+	};
+#endif
+
+#if defined(JS_BENCHMARK_TBB)
+	struct TBBRuntime
+	{
+		static constexpr const char* Name = "TBB";
+		uint32_t NumThreads;
+		tbb::task_arena Arena;
+
+		explicit TBBRuntime(BenchmarkState& state) : NumThreads(state.GetNumThreads()), Arena(static_cast<int>(state.GetNumThreads())) { }
+
+		template<typename Func>
+		void For(uint64_t count, Func func)
+		{
+			Arena.execute([&]()
+						  {
+							  tbb::parallel_for(uint64_t(0), count, [&func](uint64_t i) { func(i); });
+						  });
+		}
+	};
+#endif
+
+	/// <summary>
+	/// Fibonacci, recursively split into parallel tasks down to 'c_FibCutoff'.
+	/// </summary>
+	static constexpr int64_t c_FibCutoff = 20;
+
+	static uint64_t SerialFib(int64_t n)
+	{
+		return n < 2 ? static_cast<uint64_t>(n) : SerialFib(n - 1) + SerialFib(n - 2);
+	}
+
+	static void FibSerial(int64_t n, Clock::time_point&)
+	{
+		DoNotOptimize(SerialFib(n));
+	}
+
+	static void FibJobs(JobSystemManager& manager, int64_t n, std::atomic<uint64_t>& sum, std::atomic<uint64_t>& outstanding)
+	{
+		if (n <= c_FibCutoff)
+		{
+			sum.fetch_add(SerialFib(n), std::memory_order_relaxed);
+			outstanding.fetch_sub(1, std::memory_order_release);
+			return;
+		}
+		// No joins inside workers, the caller waits for the outstanding count to reach zero.
+		outstanding.fetch_add(2, std::memory_order_relaxed);
+		for (int64_t child : { n - 1, n - 2 })
+		{
+			manager.ScheduleJob(JobSystemManager::CreateJob(JobPriority::Normal, [&manager, child, &sum, &outstanding]()
+															{
+																FibJobs(manager, child, sum, outstanding);
+															}));
+		}
+		outstanding.fetch_sub(1, std::memory_order_release);
+	}
+
+	static void FibJobSystem(BenchmarkState& state)
+	{
+		for (auto _ : state)
+		{
+			std::atomic<uint64_t> sum = 0;
+			std::atomic<uint64_t> outstanding = 1;
+			FibJobs(state.GetManager(), state.GetArg(), sum, outstanding);
+			while (outstanding.load(std::memory_order_acquire) != 0)
+			{ }
+			DoNotOptimize(sum.load());
+		}
+		SetSpeedup(state, "Fib", FibSerial);
+	}
+
+	static uint64_t FibAsync(int64_t n, uint32_t depth, uint32_t maxDepth)
+	{
+		if (n <= c_FibCutoff || depth >= maxDepth)
+		{
+			return SerialFib(n);
+		}
+		std::future<uint64_t> first = std::async(std::launch::async, FibAsync, n - 1, depth + 1, maxDepth);
+		uint64_t const second = FibAsync(n - 2, depth + 1, maxDepth);
+		return first.get() + second;
+	}
+
+	static void FibStdAsync(BenchmarkState& state)
+	{
+		// Enough levels of std::async to give every thread a few tasks without creating thousands of threads.
+		uint32_t const maxDepth = static_cast<uint32_t>(std::ceil(std::log2(state.GetNumThreads() * 4.0)));
+		for (auto _ : state)
+		{
+			DoNotOptimize(FibAsync(state.GetArg(), 0, maxDepth));
+		}
+		SetSpeedup(state, "Fib", FibSerial);
+	}
+
+#if defined(_OPENMP)
+	static uint64_t FibOpenMPTask(int64_t n)
+	{
+		if (n <= c_FibCutoff)
+		{
+			return SerialFib(n);
+		}
+		uint64_t first = 0;
+		uint64_t second = 0;
+#pragma omp task shared(first)
+		first = FibOpenMPTask(n - 1);
+#pragma omp task shared(second)
+		second = FibOpenMPTask(n - 2);
+#pragma omp taskwait
+		return first + second;
+	}
+
+	static void FibOpenMP(BenchmarkState& state)
+	{
+		for (auto _ : state)
+		{
+			uint64_t result = 0;
+#pragma omp parallel num_threads(state.GetNumThreads())
+#pragma omp single
+			result = FibOpenMPTask(state.GetArg());
+			DoNotOptimize(result);
+		}
+		SetSpeedup(state, "Fib", FibSerial);
+	}
+#endif
+
+#if defined(JS_BENCHMARK_TBB)
+	static uint64_t FibTBBTask(int64_t n)
+	{
+		if (n <= c_FibCutoff)
+		{
+			return SerialFib(n);
+		}
+		uint64_t first = 0;
+		uint64_t second = 0;
+		tbb::task_group group;
+		group.run([&first, n]() { first = FibTBBTask(n - 1); });
+		group.run([&second, n]() { second = FibTBBTask(n - 2); });
+		group.wait();
+		return first + second;
+	}
+
+	static void FibTBB(BenchmarkState& state)
+	{
+		tbb::task_arena arena(static_cast<int>(state.GetNumThreads()));
+		for (auto _ : state)
+		{
+			uint64_t result = 0;
+			arena.execute([&result, &state]() { result = FibTBBTask(state.GetArg()); });
+			DoNotOptimize(result);
+		}
+		SetSpeedup(state, "Fib", FibSerial);
+	}
+#endif
+
+	/// <summary>
+	/// One O(n^2) n-body step, parallel over bodies.
+	/// </summary>
+	struct Bodies
+	{
+		std::vector<float> X, Y, Z, VX, VY, VZ, Mass;
+
+		explicit Bodies(uint64_t count)
+			: X(count), Y(count), Z(count), VX(count), VY(count), VZ(count), Mass(count)
+		{
+			std::mt19937 random(42);
+			std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+			for (uint64_t i = 0; i < count; ++i)
+			{
+				X[i] = distribution(random);
+				Y[i] = distribution(random);
+				Z[i] = distribution(random);
+				Mass[i] = 1.0f + distribution(random) * 0.5f;
+			}
+		}
+
+		void UpdateVelocity(uint64_t i, float deltaTime)
+		{
+			float ax = 0.0f, ay = 0.0f, az = 0.0f;
+			for (uint64_t j = 0; j < X.size(); ++j)
+			{
+				float const dx = X[j] - X[i];
+				float const dy = Y[j] - Y[i];
+				float const dz = Z[j] - Z[i];
+				float const distanceSquared = dx * dx + dy * dy + dz * dz + 0.01f;
+				float const inverseDistance = 1.0f / std::sqrt(distanceSquared);
+				float const strength = Mass[j] * inverseDistance * inverseDistance * inverseDistance;
+				ax += dx * strength;
+				ay += dy * strength;
+				az += dz * strength;
+			}
+			VX[i] += ax * deltaTime;
+			VY[i] += ay * deltaTime;
+			VZ[i] += az * deltaTime;
+		}
+
+		void UpdatePosition(uint64_t i, float deltaTime)
+		{
+			X[i] += VX[i] * deltaTime;
+			Y[i] += VY[i] * deltaTime;
+			Z[i] += VZ[i] * deltaTime;
+		}
+	};
+
+	static void NBodySerial(int64_t count, Clock::time_point&)
+	{
+		Bodies bodies(static_cast<uint64_t>(count));
+		for (int64_t i = 0; i < count; ++i)
+		{
+			bodies.UpdateVelocity(i, 0.01f);
+		}
+		for (int64_t i = 0; i < count; ++i)
+		{
+			bodies.UpdatePosition(i, 0.01f);
+		}
+		DoNotOptimize(bodies.X[0]);
+	}
+
+	template<typename Runtime>
+	static void NBody(BenchmarkState& state)
+	{
+		Runtime runtime(state);
+		uint64_t const count = static_cast<uint64_t>(state.GetArg());
+		for (auto _ : state)
+		{
+			Bodies bodies(count);
+			Bodies* bodiesPtr = &bodies;
+			runtime.For(count, [bodiesPtr](uint64_t i) { bodiesPtr->UpdateVelocity(i, 0.01f); });
+			runtime.For(count, [bodiesPtr](uint64_t i) { bodiesPtr->UpdatePosition(i, 0.01f); });
+			DoNotOptimize(bodies.X[0]);
+		}
+		SetSpeedup(state, "NBody", NBodySerial);
+	}
+
+	/// <summary>
+	/// Dense n x n matrix multiply, parallel over rows of the result.
+	/// </summary>
+	struct Matrices
+	{
+		uint64_t Size;
+		std::vector<float> A, B, C;
+
+		explicit Matrices(uint64_t size)
+			: Size(size), A(size * size, 1.5f), B(size * size, 0.5f), C(size * size, 0.0f)
+		{ }
+
+		void MultiplyRow(uint64_t row)
+		{
+			for (uint64_t k = 0; k < Size; ++k)
+			{
+				float const a = A[row * Size + k];
+				for (uint64_t column = 0; column < Size; ++column)
+				{
+					C[row * Size + column] += a * B[k * Size + column];
+				}
+			}
+		}
+	};
+
+	static void MatrixMultiplySerial(int64_t size, Clock::time_point& start)
+	{
+		Matrices matrices(static_cast<uint64_t>(size));
+		start = Clock::now();
+		for (int64_t row = 0; row < size; ++row)
+		{
+			matrices.MultiplyRow(row);
+		}
+		DoNotOptimize(matrices.C[0]);
+	}
+
+	template<typename Runtime>
+	static void MatrixMultiply(BenchmarkState& state)
+	{
+		Runtime runtime(state);
+		uint64_t const size = static_cast<uint64_t>(state.GetArg());
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			Matrices matrices(size);
+			Matrices* matricesPtr = &matrices;
+			state.ResumeTiming();
+			runtime.For(size, [matricesPtr](uint64_t row) { matricesPtr->MultiplyRow(row); });
+			DoNotOptimize(matrices.C[0]);
+		}
+		SetSpeedup(state, "MatrixMultiply", MatrixMultiplySerial);
+	}
+
+	/// <summary>
+	/// Sort blocks in parallel, then merge pairs of runs in parallel level by level.
+	/// </summary>
+	static std::vector<uint32_t> MakeKeys(uint64_t count)
+	{
+		std::vector<uint32_t> keys(count);
+		std::mt19937 random(1234);
+		for (uint32_t& key : keys)
+		{
+			key = random();
+		}
+		return keys;
+	}
+
+	static void SortSerial(int64_t count, Clock::time_point& start)
+	{
+		std::vector<uint32_t> keys = MakeKeys(static_cast<uint64_t>(count));
+		start = Clock::now();
+		std::sort(keys.begin(), keys.end());
+		DoNotOptimize(keys[0]);
+	}
+
+	template<typename Runtime>
+	static void ParallelSortWorkload(Runtime& runtime, std::vector<uint32_t>& keys, std::vector<uint32_t>& scratch)
+	{
+		uint64_t runs = 1;
+		while (runs < runtime.NumThreads * 2ull)
+		{
+			runs *= 2;
+		}
+		uint64_t const count = keys.size();
+		uint64_t const runSize = (count + runs - 1) / runs;
+		uint32_t* source = keys.data();
+		uint32_t* destination = scratch.data();
+
+		runtime.For(runs, [source, runSize, count](uint64_t run)
+					{
+						uint64_t const begin = std::min(run * runSize, count);
+						std::sort(source + begin, source + std::min(begin + runSize, count));
+					});
+
+		for (uint64_t width = runSize; width < count; width *= 2)
+		{
+			uint64_t const merges = (count + width * 2 - 1) / (width * 2);
+			runtime.For(merges, [source, destination, width, count](uint64_t merge)
+						{
+							uint64_t const begin = merge * width * 2;
+							uint64_t const middle = std::min(begin + width, count);
+							uint64_t const end = std::min(begin + width * 2, count);
+							std::merge(source + begin, source + middle, source + middle, source + end, destination + begin);
+						});
+			std::swap(source, destination);
+		}
+
+		if (source != keys.data())
+		{
+			std::copy(source, source + count, keys.data());
+		}
+	}
+
+	template<typename Runtime>
+	static void Sort(BenchmarkState& state)
+	{
+		Runtime runtime(state);
+		uint64_t const count = static_cast<uint64_t>(state.GetArg());
+		std::vector<uint32_t> const original = MakeKeys(count);
+		std::vector<uint32_t> scratch(count);
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			std::vector<uint32_t> keys = original;
+			state.ResumeTiming();
+			ParallelSortWorkload(runtime, keys, scratch);
+			DoNotOptimize(keys[0]);
+		}
+		state.SetItemsProcessed(state.GetIterations() * count);
+		SetSpeedup(state, "Sort", SortSerial);
+	}
+
+	/// <summary>
+	/// Layered DAG of small tasks, each node depends on two nodes of the layer before.
+	/// </summary>
+	static constexpr uint64_t c_DagWidth = 64;
+
+	static uint64_t DagNodeWork(uint64_t seed)
+	{
+		uint64_t value = seed;
+		for (uint32_t i = 0; i < 512; ++i)
+		{
+			value = value * 6364136223846793005ull + 1442695040888963407ull;
+		}
+		return value;
+	}
+
+	static void DagSerial(int64_t layers, Clock::time_point&)
+	{
+		uint64_t result = 0;
+		for (uint64_t node = 0; node < static_cast<uint64_t>(layers) * c_DagWidth; ++node)
+		{
+			result += DagNodeWork(node);
+		}
+		DoNotOptimize(result);
+	}
+
+	struct DagState
+	{
+		JobSystemManager* Manager = nullptr;
+		uint64_t Layers = 0;
+		std::vector<std::atomic<uint32_t>> Dependencies;
+		std::atomic<uint64_t> Finished = 0;
+		std::atomic<uint64_t> Result = 0;
+
+		explicit DagState(uint64_t layers) : Layers(layers), Dependencies(layers * c_DagWidth) { }
+
+		void Schedule(uint64_t node)
+		{
+			DagState* state = this;
+			Manager->ScheduleJob(JobSystemManager::CreateJob(JobPriority::Normal, [state, node]()
+															 {
+																 state->Run(node);
+															 }));
+		}
+
+		void Run(uint64_t node)
+		{
+			Result.fetch_add(DagNodeWork(node), std::memory_order_relaxed);
+			uint64_t const layer = node / c_DagWidth;
+			uint64_t const column = node % c_DagWidth;
+			if (layer + 1 < Layers)
+			{
+				// Node (layer, column) feeds (layer + 1, column) and (layer + 1, column - 1).
+				for (uint64_t successorColumn : { column, (column + c_DagWidth - 1) % c_DagWidth })
+				{
+					uint64_t const successor = (layer + 1) * c_DagWidth + successorColumn;
+					if (Dependencies[successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+					{
+						Schedule(successor);
+					}
+				}
+			}
+			Finished.fetch_add(1, std::memory_order_release);
+		}
+	};
+
+	static void DagJobSystem(BenchmarkState& state)
+	{
+		uint64_t const layers = static_cast<uint64_t>(state.GetArg());
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			DagState dag(layers);
+			dag.Manager = &state.GetManager();
+			for (uint64_t node = c_DagWidth; node < layers * c_DagWidth; ++node)
+			{
+				dag.Dependencies[node].store(2, std::memory_order_relaxed);
+			}
+			state.ResumeTiming();
+
+			for (uint64_t node = 0; node < c_DagWidth; ++node)
+			{
+				dag.Schedule(node);
+			}
+			SpinUntil(dag.Finished, layers * c_DagWidth);
+			DoNotOptimize(dag.Result.load());
+		}
+		state.SetItemsProcessed(state.GetIterations() * layers * c_DagWidth);
+		SetSpeedup(state, "Dag", DagSerial);
+	}
+
+	// Runtimes without dependency tracking run the DAG one layer at a time.
+	template<typename Runtime>
+	static void DagByLayer(BenchmarkState& state)
+	{
+		Runtime runtime(state);
+		uint64_t const layers = static_cast<uint64_t>(state.GetArg());
+		for (auto _ : state)
+		{
+			std::atomic<uint64_t> result = 0;
+			for (uint64_t layer = 0; layer < layers; ++layer)
+			{
+				runtime.For(c_DagWidth, [&result, layer](uint64_t column)
+							{
+								result.fetch_add(DagNodeWork(layer * c_DagWidth + column), std::memory_order_relaxed);
+							});
+			}
+			DoNotOptimize(result.load());
+		}
+		state.SetItemsProcessed(state.GetIterations() * layers * c_DagWidth);
+		SetSpeedup(state, "Dag", DagSerial);
+	}
+
+	JS_BENCHMARK_NAMED("Fib/JobSystem", FibJobSystem, { 30 }, false);
+	JS_BENCHMARK_NAMED("Fib/StdAsync", FibStdAsync, { 30 }, false);
+	JS_BENCHMARK_NAMED("NBody/JobSystem", NBody<JobSystemRuntime>, { 256, 1024 }, false);
+	JS_BENCHMARK_NAMED("NBody/StdAsync", NBody<AsyncRuntime>, { 256, 1024 }, false);
+	JS_BENCHMARK_NAMED("MatrixMultiply/JobSystem", MatrixMultiply<JobSystemRuntime>, { 128, 256 }, false);
+	JS_BENCHMARK_NAMED("MatrixMultiply/StdAsync", MatrixMultiply<AsyncRuntime>, { 128, 256 }, false);
+	JS_BENCHMARK_NAMED("Sort/JobSystem", Sort<JobSystemRuntime>, { 1 << 20 }, false);
+	JS_BENCHMARK_NAMED("Sort/StdAsync", Sort<AsyncRuntime>, { 1 << 20 }, false);
+	JS_BENCHMARK_NAMED("Dag/JobSystem", DagJobSystem, { 32 }, false);
+	JS_BENCHMARK_NAMED("Dag/StdAsync", DagByLayer<AsyncRuntime>, { 32 }, false);
+#if defined(_OPENMP)
+	JS_BENCHMARK_NAMED("Fib/OpenMP", FibOpenMP, { 30 }, false);
+	JS_BENCHMARK_NAMED("NBody/OpenMP", NBody<OpenMPRuntime>, { 256, 1024 }, false);
+	JS_BENCHMARK_NAMED("MatrixMultiply/OpenMP", MatrixMultiply<OpenMPRuntime>, { 128, 256 }, false);
+	JS_BENCHMARK_NAMED("Sort/OpenMP", Sort<OpenMPRuntime>, { 1 << 20 }, false);
+	JS_BENCHMARK_NAMED("Dag/OpenMP", DagByLayer<OpenMPRuntime>, { 32 }, false);
+#endif
+#if defined(JS_BENCHMARK_TBB)
+	JS_BENCHMARK_NAMED("Fib/TBB", FibTBB, { 30 }, false);
+	JS_BENCHMARK_NAMED("NBody/TBB", NBody<TBBRuntime>, { 256, 1024 }, false);
+	JS_BENCHMARK_NAMED("MatrixMultiply/TBB", MatrixMultiply<TBBRuntime>, { 128, 256 }, false);
+	JS_BENCHMARK_NAMED("Sort/TBB", Sort<TBBRuntime>, { 1 << 20 }, false);
+	JS_BENCHMARK_NAMED("Dag/TBB", DagByLayer<TBBRuntime>, { 32 }, false);
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,202 @@
+#include "Benchmark.h"
+#include "ParallelFor.h"
+#include <functional>
+#include <new>
+
+#if defined(_MSC_VER)
+#define JS_RESTRICT __restrict
+#else
+#define JS_RESTRICT __restrict__
+#endif
+
+// Data parallel kernels comparing ParallelForBatched, where the compiler vectorises the loop over
+// each block, with a callback per index inside the same blocks. Every run reports memory throughput as 'GB/s'.
+
+namespace Insight::JS::Bench
+{
+	static constexpr std::align_val_t c_KernelAlignment = std::align_val_t(64);
+
+	// Element 0 on a cache line, which ParallelForBatched's block alignment assumes.
+	template<typename T>
+	struct CacheLineAllocator
+	{
+		using value_type = T;
+
+		CacheLineAllocator() = default;
+		template<typename U>
+		CacheLineAllocator(CacheLineAllocator<U> const&) { }
+
+		T* allocate(size_t count) { return static_cast<T*>(::operator new(count * sizeof(T), c_KernelAlignment)); }
+		void deallocate(T* data, size_t) { ::operator delete(data, c_KernelAlignment); }
+
+		template<typename U>
+		bool operator==(CacheLineAllocator<U> const&) const { return true; }
+	};
+
+	template<typename T>
+	using AlignedVector = std::vector<T, CacheLineAllocator<T>>;
+
+	// Per index callback, called through std::function like a type erased per index API so the loop can't be vectorised.
+	using IndexFunc = std::function<void(uint64_t)>;
+
+	static void SetBandwidth(BenchmarkState& state, uint64_t bytesPerIteration)
+	{
+		double const seconds = std::chrono::duration<double>(state.GetElapsed()).count();
+		state.SetCounter("GB/s", static_cast<double>(bytesPerIteration * state.GetIterations()) / seconds / 1e9);
+	}
+
+	static uint64_t GetGrainSize(BenchmarkState& state, uint64_t count)
+	{
+		return std::max<uint64_t>(count / (state.GetNumThreads() * 4), 1);
+	}
+
+	static void Saxpy(float a, float const* JS_RESTRICT x, float* JS_RESTRICT y, uint64_t begin, uint64_t end)
+	{
+		for (uint64_t i = begin; i < end; ++i)
+		{
+			y[i] = a * x[i] + y[i];
+		}
+	}
+
+	/// <summary>
+	/// y = a * x + y over 'arg' floats, one vectorised loop per block.
+	/// </summary>
+	static void SaxpyBatched(BenchmarkState& state)
+	{
+		JobSystem& jobSystem = state.GetManager().GetMainJobSystem();
+		uint64_t const count = static_cast<uint64_t>(state.GetArg());
+		AlignedVector<float> x(count, 1.0f);
+		AlignedVector<float> y(count, 2.0f);
+		for (auto _ : state)
+		{
+			float const* xData = x.data();
+			float* yData = y.data();
+			ParallelForBatched(jobSystem, 0, count, GetGrainSize(state, count), [xData, yData](uint64_t begin, uint64_t end)
+							   {
+								   Saxpy(0.5f, xData, yData, begin, end);
+							   }, state.GetPriority());
+			DoNotOptimize(y.back());
+		}
+		state.SetItemsProcessed(state.GetIterations() * count);
+		SetBandwidth(state, count * sizeof(float) * 3);
+	}
+	JS_BENCHMARK(SaxpyBatched, { 1 << 16, 1 << 22 }, false);
+
+	/// <summary>
+	/// SaxpyBatched with a callback per index in each block, the baseline the batched version is measured against.
+	/// </summary>
+	static void SaxpyPerIndex(BenchmarkState& state)
+	{
+		JobSystem& jobSystem = state.GetManager().GetMainJobSystem();
+		uint64_t const count = static_cast<uint64_t>(state.GetArg());
+		AlignedVector<float> x(count, 1.0f);
+		AlignedVector<float> y(count, 2.0f);
+		for (auto _ : state)
+		{
+			float const* xData = x.data();
+			float* yData = y.data();
+			IndexFunc const func = [xData, yData](uint64_t i)
+			{
+				yData[i] = 0.5f * xData[i] + yData[i];
+			};
+			ParallelForBatched(jobSystem, 0, count, GetGrainSize(state, count), [&func](uint64_t begin, uint64_t end)
+							   {
+								   for (uint64_t i = begin; i < end; ++i)
+								   {
+									   func(i);
+								   }
+							   }, state.GetPriority());
+			DoNotOptimize(y.back());
+		}
+		state.SetItemsProcessed(state.GetIterations() * count);
+		SetBandwidth(state, count * sizeof(float) * 3);
+	}
+	JS_BENCHMARK(SaxpyPerIndex, { 1 << 16, 1 << 22 }, false);
+
+	struct Particle
+	{
+		float X;
+		float Y;
+		float Z;
+		float Mass;
+	};
+
+	struct ParticleStreams
+	{
+		AlignedVector<float> X;
+		AlignedVector<float> Y;
+		AlignedVector<float> Z;
+		AlignedVector<float> Mass;
+
+		explicit ParticleStreams(uint64_t count) : X(count), Y(count), Z(count), Mass(count) { }
+	};
+
+	static void AosToSoa(Particle const* JS_RESTRICT particles, float* JS_RESTRICT x, float* JS_RESTRICT y, float* JS_RESTRICT z, float* JS_RESTRICT mass, uint64_t begin, uint64_t end)
+	{
+		for (uint64_t i = begin; i < end; ++i)
+		{
+			x[i] = particles[i].X;
+			y[i] = particles[i].Y;
+			z[i] = particles[i].Z;
+			mass[i] = particles[i].Mass;
+		}
+	}
+
+	/// <summary>
+	/// Transpose 'arg' particles from an array of structs into one array per field, one loop per block.
+	/// </summary>
+	static void AosToSoaBatched(BenchmarkState& state)
+	{
+		JobSystem& jobSystem = state.GetManager().GetMainJobSystem();
+		uint64_t const count = static_cast<uint64_t>(state.GetArg());
+		AlignedVector<Particle> particles(count, Particle{ 1.0f, 2.0f, 3.0f, 4.0f });
+		ParticleStreams streams(count);
+		for (auto _ : state)
+		{
+			Particle const* source = particles.data();
+			ParticleStreams* target = &streams;
+			ParallelForBatched(jobSystem, 0, count, GetGrainSize(state, count), [source, target](uint64_t begin, uint64_t end)
+							   {
+								   AosToSoa(source, target->X.data(), target->Y.data(), target->Z.data(), target->Mass.data(), begin, end);
+							   }, state.GetPriority());
+			DoNotOptimize(streams.Mass.back());
+		}
+		state.SetItemsProcessed(state.GetIterations() * count);
+		SetBandwidth(state, count * sizeof(Particle) * 2);
+	}
+	JS_BENCHMARK(AosToSoaBatched, { 1 << 16, 1 << 22 }, false);
+
+	/// <summary>
+	/// AosToSoaBatched with a callback per index in each block.
+	/// </summary>
+	static void AosToSoaPerIndex(BenchmarkState& state)
+	{
+		JobSystem& jobSystem = state.GetManager().GetMainJobSystem();
+		uint64_t const count = static_cast<uint64_t>(state.GetArg());
+		AlignedVector<Particle> particles(count, Particle{ 1.0f, 2.0f, 3.0f, 4.0f });
+		ParticleStreams streams(count);
+		for (auto _ : state)
+		{
+			Particle const* source = particles.data();
+			ParticleStreams* target = &streams;
+			IndexFunc const func = [source, target](uint64_t i)
+			{
+				target->X[i] = source[i].X;
+				target->Y[i] = source[i].Y;
+				target->Z[i] = source[i].Z;
+				target->Mass[i] = source[i].Mass;
+			};
+			ParallelForBatched(jobSystem, 0, count, GetGrainSize(state, count), [&func](uint64_t begin, uint64_t end)
+							   {
+								   for (uint64_t i = begin; i < end; ++i)
+								   {
+									   func(i);
+								   }
+							   }, state.GetPriority());
+			DoNotOptimize(streams.Mass.back());
+		}
+		state.SetItemsProcessed(state.GetIterations() * count);
+		SetBandwidth(state, count * sizeof(Particle) * 2);
+	}
+	JS_BENCHMARK(AosToSoaPerIndex, { 1 << 16, 1 << 22 }, false);
+}
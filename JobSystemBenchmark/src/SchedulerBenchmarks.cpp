@@ -0,0 +1,217 @@
+#include "Benchmark.h"
+#include "ParallelFor.h"
+#include "ParallelSort.h"
+#include <cmath>
+#include <random>
+
+namespace Insight::JS::Bench
+{
+	// Kept below the smallest priority queue (High, 512) so a batch never overflows a queue.
+	static constexpr uint64_t c_JobBatchSize = 256;
+
+	static double ToNanoseconds(Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::nano>(duration).count();
+	}
+
+	/// <summary>
+	/// Schedule batches of jobs which do nothing but count themselves.
+	/// </summary>
+	static void EmptyJobThroughput(BenchmarkState& state)
+	{
+		JobSystemManager& manager = state.GetManager();
+		std::atomic<uint64_t> finished = 0;
+		uint64_t scheduled = 0;
+		for (auto _ : state)
+		{
+			for (uint64_t i = 0; i < c_JobBatchSize; ++i)
+			{
+				manager.ScheduleJob(JobSystemManager::CreateJob(state.GetPriority(), [&finished]()
+																{
+																	finished.fetch_add(1, std::memory_order_release);
+																}));
+			}
+			scheduled += c_JobBatchSize;
+			SpinUntil(finished, scheduled);
+		}
+		state.SetItemsProcessed(scheduled);
+	}
+	JS_BENCHMARK(EmptyJobThroughput);
+
+	/// <summary>
+	/// Time from ScheduleJob returning to the job starting on a worker.
+	/// </summary>
+	static void ScheduleToStartLatency(BenchmarkState& state)
+	{
+		JobSystemManager& manager = state.GetManager();
+		for (auto _ : state)
+		{
+			std::atomic<uint64_t> started = 0;
+			Clock::time_point startTime;
+			auto job = JobSystemManager::CreateJob(state.GetPriority(), [&started, &startTime]()
+												   {
+													   startTime = Clock::now();
+													   started.store(1, std::memory_order_release);
+												   });
+			Clock::time_point const scheduleTime = Clock::now();
+			manager.ScheduleJob(job);
+			SpinUntil(started, 1);
+			state.AddSample(ToNanoseconds(startTime - scheduleTime));
+		}
+		state.SetItemsProcessed(state.GetIterations());
+	}
+	JS_BENCHMARK(ScheduleToStartLatency);
+
+	static void ForkTree(JobSystemManager& manager, JobPriority priority, int64_t depth, std::atomic<uint64_t>& leaves)
+	{
+		if (depth == 0)
+		{
+			leaves.fetch_add(1, std::memory_order_release);
+			return;
+		}
+		for (uint32_t i = 0; i < 2; ++i)
+		{
+			manager.ScheduleJob(JobSystemManager::CreateJob(priority, [&manager, priority, depth, &leaves]()
+															{
+																ForkTree(manager, priority, depth - 1, leaves);
+															}));
+		}
+	}
+
+	/// <summary>
+	/// Binary fork tree of 'arg' levels spawned from the workers, joined when every leaf has run.
+	/// </summary>
+	static void ForkJoinDepth(BenchmarkState& state)
+	{
+		JobSystemManager& manager = state.GetManager();
+		uint64_t const leavesPerTree = 1ull << state.GetArg();
+		for (auto _ : state)
+		{
+			std::atomic<uint64_t> leaves = 0;
+			ForkTree(manager, state.GetPriority(), state.GetArg(), leaves);
+			SpinUntil(leaves, leavesPerTree);
+		}
+		state.SetItemsProcessed(state.GetIterations() * (leavesPerTree * 2 - 2));
+	}
+	JS_BENCHMARK(ForkJoinDepth, { 2, 5, 8 });
+
+	/// <summary>
+	/// ParallelFor over 'arg' floats with a grain size giving every worker 8 blocks.
+	/// </summary>
+	static void ParallelForScaling(BenchmarkState& state)
+	{
+		JobSystem& jobSystem = state.GetManager().GetMainJobSystem();
+		uint64_t const count = static_cast<uint64_t>(state.GetArg());
+		uint64_t const grainSize = std::max<uint64_t>(count / (state.GetNumThreads() * 8), 1024);
+		std::vector<float> data(count);
+		for (auto _ : state)
+		{
+			float* values = data.data();
+			ParallelFor(jobSystem, 0, count, grainSize, [values](uint64_t i)
+						{
+							values[i] = std::sqrt(static_cast<float>(i)) * 1.5f;
+						}, state.GetPriority());
+			DoNotOptimize(data.back());
+		}
+		state.SetItemsProcessed(state.GetIterations() * count);
+	}
+	JS_BENCHMARK(ParallelForScaling, { 1 << 16, 1 << 20 });
+
+	/// <summary>
+	/// ParallelSort of 'arg' random 64 bit keys, the radix sort path.
+	/// </summary>
+	static void ParallelSortKeys(BenchmarkState& state)
+	{
+		JobSystem& jobSystem = state.GetManager().GetMainJobSystem();
+		std::vector<uint64_t> source(static_cast<size_t>(state.GetArg()));
+		std::mt19937_64 random(42);
+		for (uint64_t& key : source)
+		{
+			key = random();
+		}
+		std::vector<uint64_t> keys;
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			keys = source;
+			state.ResumeTiming();
+			ParallelSort(jobSystem, keys.begin(), keys.end(), state.GetPriority());
+			DoNotOptimize(keys.front());
+		}
+		state.SetItemsProcessed(state.GetIterations() * keys.size());
+	}
+	JS_BENCHMARK(ParallelSortKeys, { 1 << 16, 1 << 20 }, false);
+
+	/// <summary>
+	/// A chain of 'arg' Then continuations, timed from scheduling the head to the tail finishing.
+	/// </summary>
+	static void ThenChainLatency(BenchmarkState& state)
+	{
+		JobSystemManager& manager = state.GetManager();
+		for (auto _ : state)
+		{
+			state.PauseTiming();
+			std::atomic<uint64_t> done = 0;
+			JobSharedPtr head = JobSystemManager::CreateJob(state.GetPriority(), []() { });
+			JobSharedPtr tail = head;
+			for (int64_t i = 1; i < state.GetArg(); ++i)
+			{
+				tail = tail->Then([]() { });
+			}
+			tail->Then([&done]()
+					   {
+						   done.store(1, std::memory_order_release);
+					   });
+			state.ResumeTiming();
+
+			manager.ScheduleJob(head);
+			SpinUntil(done, 1);
+		}
+		state.SetItemsProcessed(state.GetIterations() * state.GetArg());
+		state.SetCounter("ns_per_link", ToNanoseconds(state.GetElapsed()) / static_cast<double>(state.GetIterations() * state.GetArg()));
+	}
+	JS_BENCHMARK(ThenChainLatency, { 16, 64 });
+
+	/// <summary>
+	/// Join 'arg' jobs with a JobWaitList.
+	/// </summary>
+	static void WaitListJoin(BenchmarkState& state)
+	{
+		JobSystemManager& manager = state.GetManager();
+		for (auto _ : state)
+		{
+			JobWaitList waitList;
+			for (int64_t i = 0; i < state.GetArg(); ++i)
+			{
+				JobSharedPtr job = JobSystemManager::CreateJob(state.GetPriority(), []() { });
+				manager.ScheduleJob(job);
+				waitList.AddJobToWaitOn(job);
+			}
+			waitList.Wait();
+		}
+		state.SetItemsProcessed(state.GetIterations() * state.GetArg());
+	}
+	JS_BENCHMARK(WaitListJoin, { 16, 256 });
+
+	/// <summary>
+	/// Join 'arg' jobs with one atomic counter, the baseline for WaitListJoin's overhead.
+	/// </summary>
+	static void CounterJoin(BenchmarkState& state)
+	{
+		JobSystemManager& manager = state.GetManager();
+		for (auto _ : state)
+		{
+			std::atomic<uint64_t> finished = 0;
+			for (int64_t i = 0; i < state.GetArg(); ++i)
+			{
+				manager.ScheduleJob(JobSystemManager::CreateJob(state.GetPriority(), [&finished]()
+																{
+																	finished.fetch_add(1, std::memory_order_release);
+																}));
+			}
+			SpinUntil(finished, static_cast<uint64_t>(state.GetArg()));
+		}
+		state.SetItemsProcessed(state.GetIterations() * state.GetArg());
+	}
+	JS_BENCHMARK(CounterJoin, { 16, 256 });
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "Check.h"
+#include "ParallelSort.h"
+#include <algorithm>
+#include <functional>
+#include <random>
+
+// Guarantees of the parallel algorithms, checked against their std counterparts. Sizes below and above
+// 'ParallelAlgorithms::c_SerialThreshold' cover the serial and the parallel path.
+
+namespace Insight::JS::Check
+{
+	static std::vector<size_t> const c_Sizes = { 1000, 100000 };
+
+	/// <summary>
+	/// ParallelSort gives the same order as std::sort, through the radix sort for integers and the
+	/// merge sort for comparators, in scratch memory for trivially copyable elements and a vector otherwise.
+	/// </summary>
+	static void ParallelSortOrder(CheckContext& context)
+	{
+		std::unique_ptr<JobSystemManager> manager = StartManager(1);
+		if (!JS_EXPECT(context, manager != nullptr, "Could not start a job system with one worker."))
+		{
+			return;
+		}
+		JobSystem& jobSystem = manager->GetMainJobSystem();
+		std::mt19937_64 random(48);
+
+		auto check = [&context, &jobSystem](auto values, auto sort, std::string const& name)
+		{
+			auto expected = values;
+			std::sort(expected.begin(), expected.end(), sort);
+			ParallelSort(jobSystem, values.begin(), values.end(), sort);
+			return JS_EXPECT(context, values == expected, name + " of " + std::to_string(values.size()) + " elements is not in std::sort order.");
+		};
+		for (size_t size : c_Sizes)
+		{
+			// Negative numbers, and small numbers in a wide type where the radix sort skips passes.
+			std::vector<int32_t> signedValues(size);
+			std::vector<uint64_t> narrowValues(size);
+			std::vector<double> doubles(size);
+			std::vector<std::string> strings(size);
+			for (size_t i = 0; i < size; ++i)
+			{
+				signedValues[i] = static_cast<int32_t>(random());
+				narrowValues[i] = random() % 1000;
+				doubles[i] = static_cast<double>(random() % 100000) / 7.0;
+				strings[i] = std::to_string(random() % 100000);
+			}
+
+			std::vector<int32_t> radixSigned = signedValues;
+			std::vector<int32_t> expectedSigned = signedValues;
+			std::sort(expectedSigned.begin(), expectedSigned.end());
+			ParallelSort(jobSystem, radixSigned.begin(), radixSigned.end());
+			JS_EXPECT(context, radixSigned == expectedSigned, "Radix sort of " + std::to_string(size) + " signed integers is not in std::sort order.");
+
+			std::vector<uint64_t> radixNarrow = narrowValues;
+			std::vector<uint64_t> expectedNarrow = narrowValues;
+			std::sort(expectedNarrow.begin(), expectedNarrow.end());
+			ParallelSort(jobSystem, radixNarrow.begin(), radixNarrow.end());
+			JS_EXPECT(context, radixNarrow == expectedNarrow, "Radix sort of " + std::to_string(size) + " small integers is not in std::sort order.");
+
+			check(signedValues, std::greater<>(), "Merge sort of integers");
+			check(doubles, std::less<>(), "Merge sort of doubles");
+			check(strings, std::less<>(), "Merge sort of strings");
+		}
+		manager->Shutdown(true);
+	}
+	JS_CHECK(ParallelSortOrder);
+
+	/// <summary>
+	/// ParallelSortByKey orders records by key and keeps records with equal keys in their original order.
+	/// </summary>
+	static void ParallelSortByKeyStable(CheckContext& context)
+	{
+		std::unique_ptr<JobSystemManager> manager = StartManager(1);
+		if (!JS_EXPECT(context, manager != nullptr, "Could not start a job system with one worker."))
+		{
+			return;
+		}
+		JobSystem& jobSystem = manager->GetMainJobSystem();
+		std::mt19937 random(49);
+
+		struct Record
+		{
+			uint32_t Key;
+			uint32_t Index;
+
+			bool operator==(Record const& other) const { return Key == other.Key && Index == other.Index; }
+		};
+		for (size_t size : c_Sizes)
+		{
+			// Few distinct keys, so most records share theirs with many others.
+			std::vector<Record> records(size);
+			for (size_t i = 0; i < size; ++i)
+			{
+				records[i] = { static_cast<uint32_t>(random() % 64) << 20, static_cast<uint32_t>(i) };
+			}
+			std::vector<Record> expected = records;
+			std::stable_sort(expected.begin(), expected.end(), [](Record const& a, Record const& b) { return a.Key < b.Key; });
+			ParallelSortByKey(jobSystem, records.begin(), records.end(), [](Record const& record) { return record.Key; });
+			JS_EXPECT(context, records == expected, "Sorting " + std::to_string(size) + " records by key did not keep equal keys in order.");
+		}
+		manager->Shutdown(true);
+	}
+	JS_CHECK(ParallelSortByKeyStable);
+
+	/// <summary>
+	/// ParallelPartition gives std::stable_partition's order and returns its partition point.
+	/// </summary>
+	static void ParallelPartitionStable(CheckContext& context)
+	{
+		std::unique_ptr<JobSystemManager> manager = StartManager(1);
+		if (!JS_EXPECT(context, manager != nullptr, "Could not start a job system with one worker."))
+		{
+			return;
+		}
+		JobSystem& jobSystem = manager->GetMainJobSystem();
+		std::mt19937 random(50);
+
+		for (size_t size : c_Sizes)
+		{
+			std::vector<uint32_t> values(size);
+			for (uint32_t& value : values)
+			{
+				value = random();
+			}
+			// All, none and some of the elements match.
+			for (uint32_t modulo : { 1u, 0u, 3u })
+			{
+				auto pred = [modulo](uint32_t value) { return modulo == 0 ? false : value % modulo == 0; };
+				std::vector<uint32_t> partitioned = values;
+				std::vector<uint32_t> expected = values;
+				auto const expectedPoint = std::stable_partition(expected.begin(), expected.end(), pred);
+				auto const point = ParallelPartition(jobSystem, partitioned.begin(), partitioned.end(), pred);
+				JS_EXPECT(context, partitioned == expected, "Partitioning " + std::to_string(size) + " elements by modulo " + std::to_string(modulo)
+						  + " did not keep them in order.");
+				JS_EXPECT(context, point - partitioned.begin() == expectedPoint - expected.begin(), "Partitioning " + std::to_string(size)
+						  + " elements by modulo " + std::to_string(modulo) + " returned the wrong partition point.");
+			}
+		}
+		manager->Shutdown(true);
+	}
+	JS_CHECK(ParallelPartitionStable);
+}
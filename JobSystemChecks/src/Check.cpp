@@ -0,0 +1,160 @@
+#include "Check.h"
+#include <cstring>
+#include <iostream>
+
+namespace Insight::JS::Check
+{
+	std::vector<CheckDefinition>& GetChecks()
+	{
+		static std::vector<CheckDefinition> checks;
+		return checks;
+	}
+
+	CheckRegistration::CheckRegistration(const char* name, CheckFunc func)
+	{
+		CheckDefinition definition;
+		definition.Name = name;
+		definition.Func = func;
+		GetChecks().push_back(std::move(definition));
+	}
+
+	bool CheckContext::Expect(bool condition, const char* expression, std::string const& message, const char* file, int line)
+	{
+		if (!condition)
+		{
+			++m_failures;
+			std::cout << "[FAIL] " << m_name << ": " << message << '\n'
+				<< "       " << expression << " (" << file << ':' << line << ')' << '\n';
+		}
+		return condition;
+	}
+
+	std::unique_ptr<JobSystemManager> StartManager(uint32_t numThreads, JobSchedulingOptions const& scheduling)
+	{
+		JobSystemManagerOptions options;
+		options.NumThreads = numThreads;
+		options.ThreadAffinity = false;
+		options.NumBlockingThreads = 1;
+		options.AsyncIOQueueDepth = 0;
+		options.Scheduling = scheduling;
+
+		std::unique_ptr<JobSystemManager> manager = std::make_unique<JobSystemManager>();
+		if (manager->Init(options) != JobSystemManager::ReturnCode::Succes)
+		{
+			manager->Shutdown(true);
+			return nullptr;
+		}
+		return manager;
+	}
+
+	bool WaitFor(std::atomic<uint32_t> const& counter, uint32_t target, std::chrono::milliseconds timeout)
+	{
+		Clock::time_point const end = Clock::now() + timeout;
+		while (counter.load(std::memory_order_acquire) < target)
+		{
+			if (Clock::now() >= end)
+			{
+				return false;
+			}
+			// Yield, the checks must also pass on machines with fewer cores than threads.
+			std::this_thread::yield();
+		}
+		return true;
+	}
+
+	void BusyWait(Clock::duration duration)
+	{
+		Clock::time_point const end = Clock::now() + duration;
+		while (Clock::now() < end)
+		{ }
+	}
+
+	WorkerGate::WorkerGate(JobSystemManager& manager)
+		: m_open(std::make_shared<std::atomic<bool>>(false))
+	{
+		std::shared_ptr<std::atomic<bool>> started = std::make_shared<std::atomic<bool>>(false);
+		manager.ScheduleJob(JobSystemManager::CreateJob(JobPriority::Normal, [open = m_open, started]()
+														{
+															started->store(true, std::memory_order_release);
+															while (!open->load(std::memory_order_acquire))
+															{
+																std::this_thread::yield();
+															}
+														}));
+
+		Clock::time_point const end = Clock::now() + std::chrono::seconds(10);
+		while (!started->load(std::memory_order_acquire) && Clock::now() < end)
+		{
+			std::this_thread::yield();
+		}
+		m_held = started->load(std::memory_order_acquire);
+	}
+
+	WorkerGate::~WorkerGate()
+	{
+		Open();
+	}
+
+	void WorkerGate::Open()
+	{
+		m_open->store(true, std::memory_order_release);
+	}
+
+	static int RunAll(std::string const& filter)
+	{
+		uint32_t run = 0;
+		uint32_t failed = 0;
+		for (CheckDefinition const& definition : GetChecks())
+		{
+			if (!filter.empty() && definition.Name.find(filter) == std::string::npos)
+			{
+				continue;
+			}
+
+			CheckContext context(definition.Name);
+			try
+			{
+				definition.Func(context);
+			}
+			catch (std::exception const& exception)
+			{
+				context.Expect(false, "no exception", exception.what(), __FILE__, __LINE__);
+			}
+			catch (...)
+			{
+				context.Expect(false, "no exception", "Unknown exception.", __FILE__, __LINE__);
+			}
+
+			++run;
+			if (context.GetFailures() > 0)
+			{
+				++failed;
+			}
+			else
+			{
+				std::cout << "[ OK ] " << definition.Name << '\n';
+			}
+		}
+
+		std::cout << run - failed << '/' << run << " checks passed." << '\n';
+		return failed == 0 ? 0 : 1;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string filter;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strncmp(argv[i], "--filter=", 9) == 0)
+		{
+			filter = argv[i] + 9;
+		}
+		else
+		{
+			std::cout << "Usage: " << argv[0] << " [--filter=substring]" << '\n';
+			return 1;
+		}
+	}
+	return Insight::JS::Check::RunAll(filter);
+}
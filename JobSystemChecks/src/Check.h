@@ -0,0 +1,88 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include "JobSystem.h"
+
+#define JS_CHECK_CONCAT_IMPL(a, b) a##b
+#define JS_CHECK_CONCAT(a, b) JS_CHECK_CONCAT_IMPL(a, b)
+
+// JS_CHECK(Func)
+#define JS_CHECK(func) \
+	static ::Insight::JS::Check::CheckRegistration JS_CHECK_CONCAT(s_check_, __LINE__)(#func, func)
+// JS_EXPECT(context, condition, message), records a failure and returns false if 'condition' is false. The check carries on.
+#define JS_EXPECT(context, condition, message) \
+	(context).Expect((condition), #condition, (message), __FILE__, __LINE__)
+
+namespace Insight::JS::Check
+{
+	using Clock = std::chrono::steady_clock;
+
+	/// <summary>
+	/// Passed to every check, collects its failures.
+	/// </summary>
+	class CheckContext
+	{
+	public:
+		explicit CheckContext(std::string name) : m_name(std::move(name)) { }
+
+		bool Expect(bool condition, const char* expression, std::string const& message, const char* file, int line);
+
+		std::string const& GetName() const { return m_name; }
+		uint32_t GetFailures() const { return m_failures; }
+
+	private:
+		std::string m_name;
+		uint32_t m_failures = 0;
+	};
+
+	using CheckFunc = void(*)(CheckContext&);
+
+	struct CheckDefinition
+	{
+		std::string Name;
+		CheckFunc Func = nullptr;
+	};
+
+	/// <summary>
+	/// Static registration of a check, see 'JS_CHECK'.
+	/// </summary>
+	struct CheckRegistration
+	{
+		CheckRegistration(const char* name, CheckFunc func);
+	};
+
+	std::vector<CheckDefinition>& GetChecks();
+
+	// Start a manager with 'numThreads' workers, nullptr if Init failed. Each check starts its own so no state leaks between them.
+	std::unique_ptr<JobSystemManager> StartManager(uint32_t numThreads, JobSchedulingOptions const& scheduling = JobSchedulingOptions());
+
+	// Wait for 'counter' to reach 'target'. Returns false once 'timeout' has passed, so a hang fails the check instead of the run.
+	bool WaitFor(std::atomic<uint32_t> const& counter, uint32_t target, std::chrono::milliseconds timeout = std::chrono::seconds(30));
+
+	// Spin for 'duration' of wall clock time, a job of known length.
+	void BusyWait(Clock::duration duration);
+
+	/// <summary>
+	/// Holds the only worker of a manager in a job, so jobs scheduled meanwhile queue up and the
+	/// order one worker dequeues them in can be checked once the gate is opened.
+	/// </summary>
+	class WorkerGate
+	{
+	public:
+		explicit WorkerGate(JobSystemManager& manager);
+		~WorkerGate();
+
+		// False if the worker never picked the gate job up.
+		bool IsHeld() const { return m_held; }
+		void Open();
+
+	private:
+		std::shared_ptr<std::atomic<bool>> m_open;
+		bool m_held = false;
+	};
+}
@@ -0,0 +1,90 @@
+#include "Check.h"
+#include "Pipeline.h"
+
+// Guarantees of Pipeline stage modes and its token bound.
+
+namespace Insight::JS::Check
+{
+	/// <summary>
+	/// A SerialInOrder stage sees the tokens in the order the source produced them, even when they reach it
+	/// out of order, serial stages run one token at a time, dropped tokens skip the later stages and no more
+	/// than 'maxTokensInFlight' tokens exist. Holds for a second run of the same pipeline too.
+	/// </summary>
+	static void PipelineOrder(CheckContext& context)
+	{
+		std::unique_ptr<JobSystemManager> manager = StartManager(1);
+		if (!JS_EXPECT(context, manager != nullptr, "Could not start a job system with one worker."))
+		{
+			return;
+		}
+
+		struct Token
+		{
+			uint32_t Sequence = 0;
+		};
+		uint32_t const inputs = 2000;
+		uint32_t const maxTokens = 8;
+		uint32_t next = 0;
+		uint32_t maxInFlight = 0;
+		std::atomic<uint32_t> inSerialStage = 0;
+		bool serialOverlapped = false;
+		bool droppedSeen = false;
+		std::vector<uint32_t> order;
+
+		Pipeline<Token> pipeline(manager->GetMainJobSystem(), maxTokens);
+		pipeline.SetSource([&](Token& token)
+						   {
+							   if (next == inputs)
+							   {
+								   return false;
+							   }
+							   token.Sequence = next++;
+							   maxInFlight = std::max(maxInFlight, pipeline.GetTokensInFlight());
+							   return true;
+						   })
+			.AddStage(PipelineStageMode::Parallel, [](Token& token)
+					  {
+						  // Helping runs the tokens behind this one first, so they reach the later stages before it does.
+						  if (token.Sequence % 3 == 0)
+						  {
+							  for (uint32_t i = 0; i < 4; ++i)
+							  {
+								  JobSystemManager::RunPendingJob();
+							  }
+						  }
+					  })
+			.AddStage(PipelineStageMode::Parallel, [](Token& token) { return token.Sequence % 5 != 0; })
+			.AddStage(PipelineStageMode::SerialOutOfOrder, [&](Token& token)
+					  {
+						  serialOverlapped |= inSerialStage.fetch_add(1) != 0;
+						  droppedSeen |= token.Sequence % 5 == 0;
+						  inSerialStage.fetch_sub(1);
+					  })
+			.AddStage(PipelineStageMode::SerialInOrder, [&order](Token& token) { order.push_back(token.Sequence); });
+
+		for (uint32_t run = 0; run < 2; ++run)
+		{
+			next = 0;
+			order.clear();
+			pipeline.Run();
+
+			std::vector<uint32_t> expected;
+			for (uint32_t sequence = 0; sequence < inputs; ++sequence)
+			{
+				if (sequence % 5 != 0)
+				{
+					expected.push_back(sequence);
+				}
+			}
+			std::string const runName = "Run " + std::to_string(run) + ": ";
+			JS_EXPECT(context, order == expected, runName + "the SerialInOrder stage did not see every kept token once, in source order.");
+			JS_EXPECT(context, !serialOverlapped, runName + "a serial stage ran two tokens at once.");
+			JS_EXPECT(context, !droppedSeen, runName + "a dropped token reached a later stage.");
+			JS_EXPECT(context, maxInFlight <= maxTokens, runName + std::to_string(maxInFlight) + " tokens were in flight, at most "
+					  + std::to_string(maxTokens) + " may be.");
+			JS_EXPECT(context, pipeline.GetTokensInFlight() == 0, runName + "tokens were still in flight after Run returned.");
+		}
+		manager->Shutdown(true);
+	}
+	JS_CHECK(PipelineOrder);
+}
@@ -0,0 +1,234 @@
+#include "Check.h"
+#include "Task.h"
+#include <algorithm>
+#include <stdexcept>
+
+// Guarantees of job exceptions and JobResult.
+
+namespace Insight::JS::Check
+{
+	// True if 'func' throws a std::runtime_error with 'message'.
+	template<typename Func>
+	static bool ThrowsRuntimeError(Func func, std::string const& message)
+	{
+		try
+		{
+			func();
+		}
+		catch (std::runtime_error const& exception)
+		{
+			return message == exception.what();
+		}
+		catch (...)
+		{ }
+		return false;
+	}
+
+	/// <summary>
+	/// A job's exception is rethrown by waiting on it and by its result, 'CancelOnParentException'
+	/// children and their children are cancelled and rethrow it, 'RunAnyway' children run, and
+	/// the worker which ran the job carries on.
+	/// </summary>
+	static void ExceptionPropagation(CheckContext& context)
+	{
+		std::unique_ptr<JobSystemManager> manager = StartManager(1);
+		if (!JS_EXPECT(context, manager != nullptr, "Could not start a job system with one worker."))
+		{
+			return;
+		}
+
+		auto thrower = JobSystemManager::CreateJob(JobPriority::Normal, []() -> int { throw std::runtime_error("Job"); });
+		std::atomic<uint32_t> childrenRan = 0;
+		auto runAnyway = thrower->Then(JobExceptionPolicy::RunAnyway, [&childrenRan]() { childrenRan.fetch_add(1); return 1; });
+		auto canceled = thrower->Then(JobExceptionPolicy::CancelOnParentException, [&childrenRan]() { childrenRan.fetch_add(1); return 2; });
+		auto canceledChild = canceled->Then([&childrenRan]() { childrenRan.fetch_add(1); });
+		manager->ScheduleJob(thrower);
+
+		JS_EXPECT(context, ThrowsRuntimeError([&thrower]() { thrower->Wait(); }, "Job"), "Wait did not rethrow the job's exception.");
+		JS_EXPECT(context, ThrowsRuntimeError([&thrower]() { thrower->GetResult().GetResult(); }, "Job"), "GetResult did not rethrow the job's exception.");
+		JS_EXPECT(context, runAnyway->GetResult().GetResult() == 1, "A RunAnyway child did not run.");
+		JS_EXPECT(context, ThrowsRuntimeError([&canceled]() { canceled->Wait(); }, "Job"), "A cancelled child did not rethrow its parent's exception.");
+		JS_EXPECT(context, ThrowsRuntimeError([&canceledChild]() { canceledChild->Wait(); }, "Job"), "The child of a cancelled child did not rethrow the exception.");
+		JS_EXPECT(context, canceled->GetState() == JobState::Canceled && canceledChild->GetState() == JobState::Canceled, "Children of a job which threw were not cancelled.");
+		JS_EXPECT(context, childrenRan.load() == 1, "A cancelled child ran.");
+
+		// One worker, so this runs on the worker which ran the throwing job.
+		auto after = JobSystemManager::CreateJob(JobPriority::Normal, []() { return 7; });
+		manager->ScheduleJob(after);
+		JS_EXPECT(context, after->GetResult().GetResult() == 7, "The worker stopped running jobs after one threw.");
+		manager->Shutdown(true);
+	}
+	JS_CHECK(ExceptionPropagation);
+
+	/// <summary>
+	/// A result read on another thread is complete as soon as it reads as ready, 'GetResult' waits for it,
+	/// and a job cancelled before it ran throws instead of leaving its readers waiting.
+	/// </summary>
+	static void ResultPublication(CheckContext& context)
+	{
+		std::unique_ptr<JobSystemManager> manager = StartManager(1);
+		if (!JS_EXPECT(context, manager != nullptr, "Could not start a job system with one worker."))
+		{
+			return;
+		}
+
+		// The main thread polls 'TryGetResult' while the worker writes, a torn result would show up as mixed values.
+		uint32_t const runs = 2000;
+		uint32_t const resultSize = 64;
+		for (uint32_t run = 0; run < runs; ++run)
+		{
+			auto job = JobSystemManager::CreateJob(JobPriority::Normal, [run, resultSize]() { return std::vector<uint32_t>(resultSize, run); });
+			std::vector<uint32_t> result;
+			if (!JS_EXPECT(context, !job->GetResult().TryGetResult(result), "A result read as ready before its job was scheduled."))
+			{
+				break;
+			}
+			manager->ScheduleJob(job);
+			while (!job->GetResult().TryGetResult(result))
+			{
+				std::this_thread::yield();
+			}
+			bool const complete = result.size() == resultSize && std::all_of(result.begin(), result.end(), [run](uint32_t value) { return value == run; });
+			if (!JS_EXPECT(context, complete, "Run " + std::to_string(run) + " read a result which was not fully written."))
+			{
+				break;
+			}
+		}
+
+		auto waited = JobSystemManager::CreateJob(JobPriority::Normal, []() { Thread::SleepFor(10); return 42; });
+		manager->ScheduleJob(waited);
+		JS_EXPECT(context, waited->GetResult().GetResult() == 42, "GetResult did not wait for the result.");
+
+		auto canceled = JobSystemManager::CreateJob(JobPriority::Normal, []() { return 1; });
+		manager->CancelTimer(manager->ScheduleJobAfter(canceled, std::chrono::seconds(10)));
+		bool threw = false;
+		try
+		{
+			canceled->GetResult().GetResult();
+		}
+		catch (std::exception const&)
+		{
+			threw = true;
+		}
+		JS_EXPECT(context, threw, "Reading the result of a cancelled job did not throw.");
+		manager->Shutdown(true);
+	}
+	JS_CHECK(ResultPublication);
+
+	/// <summary>
+	/// Only one consumer can move a job's result out: a second typed 'Then', WhenAll or WhenAny on it throws,
+	/// while untyped children and void results can be added any number of times.
+	/// </summary>
+	static void ResultClaims(CheckContext& context)
+	{
+		std::unique_ptr<JobSystemManager> manager = StartManager(1);
+		if (!JS_EXPECT(context, manager != nullptr, "Could not start a job system with one worker."))
+		{
+			return;
+		}
+
+		auto throwsLogicError = [](auto func)
+		{
+			try
+			{
+				func();
+			}
+			catch (std::logic_error const&)
+			{
+				return true;
+			}
+			return false;
+		};
+
+		auto job = JobSystemManager::CreateJob(JobPriority::Normal, []() { return std::string("Result"); });
+		auto taker = job->Then([](std::string result) { return result.size(); });
+		auto untyped = job->Then([]() { return 1; });
+		JS_EXPECT(context, throwsLogicError([&job]() { job->Then([](std::string result) { return result; }); }), "A second typed Then did not throw.");
+		JS_EXPECT(context, throwsLogicError([&job]() { WhenAll(job); }), "WhenAll on a job whose result is taken did not throw.");
+		JS_EXPECT(context, throwsLogicError([&job]() { WhenAny(job); }), "WhenAny on a job whose result is taken did not throw.");
+		manager->ScheduleJob(job);
+		JS_EXPECT(context, taker->GetResult().GetResult() == 6 && untyped->GetResult().GetResult() == 1, "The children of the job did not run.");
+
+		auto voidJob = JobSystemManager::CreateJob(JobPriority::Normal, []() { });
+		auto all = WhenAll(voidJob);
+		auto any = WhenAny(voidJob);
+		manager->ScheduleJob(voidJob);
+		all->Wait();
+		any->Wait();
+		JS_EXPECT(context, all->IsFinished() && any->IsFinished(), "Void results could not be combined more than once.");
+		manager->Shutdown(true);
+	}
+	JS_CHECK(ResultClaims);
+
+	/// <summary>
+	/// WhenAny runs on the first job with a result or exception, a canceled job doesn't count
+	/// unless every job is canceled, then it throws.
+	/// </summary>
+	static void WhenAnySkipsCanceled(CheckContext& context)
+	{
+		std::unique_ptr<JobSystemManager> manager = StartManager(1);
+		if (!JS_EXPECT(context, manager != nullptr, "Could not start a job system with one worker."))
+		{
+			return;
+		}
+
+		auto canceled = JobSystemManager::CreateJob(JobPriority::Normal, []() { return 1; });
+		auto later = JobSystemManager::CreateJob(JobPriority::Normal, []() { return std::string("Later"); });
+		auto any = WhenAny(canceled, later);
+		manager->CancelTimer(manager->ScheduleJobAfter(canceled, std::chrono::seconds(10)));
+		JS_EXPECT(context, !any->IsFinished() && !any->IsReady(), "WhenAny ran when one of its jobs was canceled.");
+		manager->ScheduleJob(later);
+		auto const value = any->GetResult().GetResult();
+		JS_EXPECT(context, value.index() == 1 && std::get<1>(value) == "Later", "WhenAny did not take the result of the job which ran.");
+
+		auto first = JobSystemManager::CreateJob(JobPriority::Normal, []() { return 1; });
+		auto second = JobSystemManager::CreateJob(JobPriority::Normal, []() { return 2; });
+		auto none = WhenAny(first, second);
+		manager->CancelTimer(manager->ScheduleJobAfter(first, std::chrono::seconds(10)));
+		manager->CancelTimer(manager->ScheduleJobAfter(second, std::chrono::seconds(10)));
+		JS_EXPECT(context, ThrowsRuntimeError([&none]() { none->GetResult().GetResult(); }, "[WhenAny] Every job was canceled."),
+				  "WhenAny of canceled jobs did not throw.");
+		manager->Shutdown(true);
+	}
+	JS_CHECK(WhenAnySkipsCanceled);
+
+	static Task<int> AwaitJob(JobWithResultSharedPtr<int> job)
+	{
+		int const value = co_await job;
+		co_return value + 1;
+	}
+
+	/// <summary>
+	/// A job waiting on a task whose coroutine waits on a job queued behind it finishes on a single worker.
+	/// </summary>
+	static void TaskWaitHelps(CheckContext& context)
+	{
+		std::unique_ptr<JobSystemManager> manager = StartManager(1);
+		if (!JS_EXPECT(context, manager != nullptr, "Could not start a job system with one worker."))
+		{
+			return;
+		}
+
+		std::atomic<uint32_t> finished = 0;
+		int result = 0;
+		JobSystem& jobSystem = manager->GetMainJobSystem();
+		manager->ScheduleJob(JobSystemManager::CreateJob(JobPriority::Normal, [&jobSystem, &finished, &result]()
+														 {
+															 auto inner = JobSystem::CreateJob(JobPriority::Normal, []() { return 41; });
+															 Task<int> task = AwaitJob(inner);
+															 task.Schedule(jobSystem);
+															 jobSystem.ScheduleJob(inner);
+															 result = task.GetResult();
+															 finished.fetch_add(1, std::memory_order_release);
+														 }));
+		if (!JS_EXPECT(context, WaitFor(finished, 1, std::chrono::seconds(10)), "Task::GetResult on the only worker deadlocked."))
+		{
+			// The worker never returns, leave the manager running rather than joining it.
+			manager.release();
+			return;
+		}
+		JS_EXPECT(context, result == 42, "The task returned the wrong result.");
+		manager->Shutdown(true);
+	}
+	JS_CHECK(TaskWaitHelps);
+}
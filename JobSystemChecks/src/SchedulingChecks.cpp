@@ -0,0 +1,339 @@
+#include "Check.h"
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+// Guarantees of the queue policies, deadlines and timers. Each check runs one worker, so the order
+// jobs start in is the order they were dequeued in.
+
+namespace Insight::JS::Check
+{
+	/// <summary>
+	/// WeightedFair: while every queue has jobs, each round of High + Normal + Low weight dequeues
+	/// takes exactly 'weight' jobs from each queue.
+	/// </summary>
+	static void WeightedFairRatio(CheckContext& context)
+	{
+		JobSchedulingOptions scheduling;
+		scheduling.Policy = JobSchedulingPolicy::WeightedFair;
+		std::unique_ptr<JobSystemManager> manager = StartManager(1, scheduling);
+		if (!JS_EXPECT(context, manager != nullptr, "Could not start a job system with one worker."))
+		{
+			return;
+		}
+
+		std::array<uint32_t, 3> const weights = { scheduling.HighWeight, scheduling.NormalWeight, scheduling.LowWeight };
+		uint32_t const roundSize = weights[0] + weights[1] + weights[2];
+		// 32 rounds keep High within its 512 job queue.
+		uint32_t const rounds = 32;
+
+		std::vector<JobPriority> order(roundSize * rounds);
+		std::atomic<uint32_t> started = 0;
+		{
+			WorkerGate gate(*manager);
+			JS_EXPECT(context, gate.IsHeld(), "The worker never started the gate job.");
+			for (uint8_t priority = 0; priority < 3; ++priority)
+			{
+				for (uint32_t i = 0; i < weights[priority] * rounds; ++i)
+				{
+					manager->ScheduleJob(JobSystemManager::CreateJob(static_cast<JobPriority>(priority), [&order, &started, priority]()
+																	 {
+																		 order[started.load(std::memory_order_relaxed)] = static_cast<JobPriority>(priority);
+																		 started.fetch_add(1, std::memory_order_release);
+																	 }));
+				}
+			}
+		}
+		if (JS_EXPECT(context, WaitFor(started, static_cast<uint32_t>(order.size())), "Not every job ran."))
+		{
+			// Every queue still has jobs in all but the last round.
+			for (uint32_t round = 0; round + 1 < rounds; ++round)
+			{
+				std::array<uint32_t, 3> counts = { };
+				for (uint32_t i = round * roundSize; i < (round + 1) * roundSize; ++i)
+				{
+					++counts[static_cast<uint8_t>(order[i])];
+				}
+				if (!JS_EXPECT(context, counts == weights, "Round " + std::to_string(round) + " took High/Normal/Low " + std::to_string(counts[0]) + '/'
+							   + std::to_string(counts[1]) + '/' + std::to_string(counts[2]) + " jobs, not their weights."))
+				{
+					break;
+				}
+			}
+		}
+		manager->Shutdown(true);
+	}
+	JS_CHECK(WeightedFairRatio);
+
+	/// <summary>
+	/// Aging: Low jobs waiting behind a steady stream of High jobs each start within 'LowAgingMs',
+	/// measured in High jobs of known length which start before them. Low jobs queued together
+	/// don't wait an aging interval each.
+	/// </summary>
+	static void AgingBound(CheckContext& context)
+	{
+		JobSchedulingOptions scheduling;
+		scheduling.Policy = JobSchedulingPolicy::Aging;
+		scheduling.LowAgingMs = 16;
+		std::unique_ptr<JobSystemManager> manager = StartManager(1, scheduling);
+		if (!JS_EXPECT(context, manager != nullptr, "Could not start a job system with one worker."))
+		{
+			return;
+		}
+
+		std::chrono::milliseconds const highJobTime(1);
+		uint32_t const highJobs = 400;
+		uint32_t const lowJobs = 8;
+		std::atomic<uint32_t> highStarted = 0;
+		std::atomic<uint32_t> finished = 0;
+		{
+			WorkerGate gate(*manager);
+			JS_EXPECT(context, gate.IsHeld(), "The worker never started the gate job.");
+			for (uint32_t i = 0; i < highJobs; ++i)
+			{
+				manager->ScheduleJob(JobSystemManager::CreateJob(JobPriority::High, [&highStarted, &finished, highJobTime]()
+																 {
+																	 highStarted.fetch_add(1, std::memory_order_acq_rel);
+																	 BusyWait(highJobTime);
+																	 finished.fetch_add(1, std::memory_order_release);
+																 }));
+			}
+		}
+
+		// Let the High jobs run for a while first, so the Low queue has been seen empty recently.
+		JS_EXPECT(context, WaitFor(highStarted, 20), "The High jobs never started.");
+		std::vector<uint32_t> highStartedBeforeLow(lowJobs);
+		for (uint32_t i = 0; i < lowJobs; ++i)
+		{
+			manager->ScheduleJob(JobSystemManager::CreateJob(JobPriority::Low, [&highStarted, &highStartedBeforeLow, &finished, i]()
+															 {
+																 highStartedBeforeLow[i] = highStarted.load(std::memory_order_acquire);
+																 finished.fetch_add(1, std::memory_order_release);
+															 }));
+		}
+		// Read after scheduling, a delay here only makes the count smaller.
+		uint32_t const highStartedAtSchedule = highStarted.load(std::memory_order_acquire);
+
+		if (JS_EXPECT(context, WaitFor(finished, highJobs + lowJobs), "Not every job ran."))
+		{
+			// The aging interval in High jobs, plus the one running when the interval ended.
+			uint32_t const maxHighJobs = scheduling.LowAgingMs / static_cast<uint32_t>(highJobTime.count()) + 2;
+			for (uint32_t i = 0; i < lowJobs; ++i)
+			{
+				uint32_t const highJobsWaited = highStartedBeforeLow[i] - highStartedAtSchedule;
+				if (!JS_EXPECT(context, highJobsWaited <= maxHighJobs, "Low job " + std::to_string(i) + " waited for " + std::to_string(highJobsWaited)
+							   + " High jobs, at most " + std::to_string(maxHighJobs) + " fit in its aging interval."))
+				{
+					break;
+				}
+			}
+		}
+		manager->Shutdown(true);
+	}
+	JS_CHECK(AgingBound);
+
+	/// <summary>
+	/// Jobs with a deadline run earliest deadline first, and before any job without one.
+	/// </summary>
+	static void DeadlineOrder(CheckContext& context)
+	{
+		std::unique_ptr<JobSystemManager> manager = StartManager(1);
+		if (!JS_EXPECT(context, manager != nullptr, "Could not start a job system with one worker."))
+		{
+			return;
+		}
+
+		uint32_t const deadlineJobs = 64;
+		uint32_t const otherJobs = 16;
+		std::vector<uint32_t> deadlineOrder(deadlineJobs);
+		std::iota(deadlineOrder.begin(), deadlineOrder.end(), 0);
+		std::shuffle(deadlineOrder.begin(), deadlineOrder.end(), std::mt19937(37));
+
+		// Deadline rank of each job in the order it started, UINT32_MAX for jobs without a deadline.
+		std::vector<uint32_t> order(deadlineJobs + otherJobs);
+		std::atomic<uint32_t> started = 0;
+		auto recordJob = [&order, &started](uint32_t rank)
+		{
+			return JobSystemManager::CreateJob(JobPriority::High, [&order, &started, rank]()
+											   {
+												   order[started.load(std::memory_order_relaxed)] = rank;
+												   started.fetch_add(1, std::memory_order_release);
+											   });
+		};
+		{
+			WorkerGate gate(*manager);
+			JS_EXPECT(context, gate.IsHeld(), "The worker never started the gate job.");
+			for (uint32_t i = 0; i < otherJobs; ++i)
+			{
+				manager->ScheduleJob(recordJob(UINT32_MAX));
+			}
+			Clock::time_point const now = Clock::now();
+			for (uint32_t rank : deadlineOrder)
+			{
+				manager->ScheduleJobWithDeadline(recordJob(rank), now + std::chrono::seconds(10) + std::chrono::milliseconds(rank));
+			}
+		}
+		if (JS_EXPECT(context, WaitFor(started, static_cast<uint32_t>(order.size())), "Not every job ran."))
+		{
+			for (uint32_t i = 0; i < order.size(); ++i)
+			{
+				uint32_t const expected = i < deadlineJobs ? i : UINT32_MAX;
+				if (!JS_EXPECT(context, order[i] == expected, "Job " + std::to_string(i) + " to start had deadline rank "
+							   + std::to_string(static_cast<int32_t>(order[i])) + ", expected " + std::to_string(static_cast<int32_t>(expected)) + '.'))
+				{
+					break;
+				}
+			}
+		}
+		manager->Shutdown(true);
+	}
+	JS_CHECK(DeadlineOrder);
+
+	/// <summary>
+	/// A Then chain run inline on its worker gives way to a queued job after a bounded number of links,
+	/// and at once to a High job.
+	/// </summary>
+	static void ContinuationYields(CheckContext& context)
+	{
+		std::unique_ptr<JobSystemManager> manager = StartManager(1);
+		if (!JS_EXPECT(context, manager != nullptr, "Could not start a job system with one worker."))
+		{
+			return;
+		}
+
+		uint32_t const links = 200;
+		// The cadence workers check timers at, a chain this long never runs inline in one go.
+		uint32_t const maxInlineLinks = 32;
+		std::atomic<uint32_t> linksRun = 0;
+		std::atomic<uint32_t> finished = 0;
+		uint32_t linksBeforeNormal = 0;
+		uint32_t linksBeforeHigh = 0;
+		auto head = JobSystemManager::CreateJob(JobPriority::Normal, [&manager, &linksRun, &finished, &linksBeforeHigh]()
+												{
+													linksRun.fetch_add(1, std::memory_order_relaxed);
+													manager->ScheduleJob(JobSystemManager::CreateJob(JobPriority::High, [&linksRun, &finished, &linksBeforeHigh]()
+																									 {
+																										 linksBeforeHigh = linksRun.load(std::memory_order_relaxed);
+																										 finished.fetch_add(1, std::memory_order_release);
+																									 }));
+												});
+		JobSharedPtr last = head;
+		for (uint32_t i = 1; i < links; ++i)
+		{
+			last = last->Then([&linksRun]() { linksRun.fetch_add(1, std::memory_order_relaxed); });
+		}
+		last->Then([&finished]() { finished.fetch_add(1, std::memory_order_release); });
+		{
+			WorkerGate gate(*manager);
+			JS_EXPECT(context, gate.IsHeld(), "The worker never started the gate job.");
+			manager->ScheduleJob(head);
+			manager->ScheduleJob(JobSystemManager::CreateJob(JobPriority::Normal, [&linksRun, &finished, &linksBeforeNormal]()
+															 {
+																 linksBeforeNormal = linksRun.load(std::memory_order_relaxed);
+																 finished.fetch_add(1, std::memory_order_release);
+															 }));
+		}
+		if (JS_EXPECT(context, WaitFor(finished, 3), "Not every job ran."))
+		{
+			JS_EXPECT(context, linksBeforeHigh == 1, "A High job waited for " + std::to_string(linksBeforeHigh) + " links of a Normal chain.");
+			JS_EXPECT(context, linksBeforeNormal <= maxInlineLinks, "A queued job waited for " + std::to_string(linksBeforeNormal)
+					  + " links of a chain, at most " + std::to_string(maxInlineLinks) + " run inline.");
+		}
+		manager->Shutdown(true);
+	}
+	JS_CHECK(ContinuationYields);
+
+	/// <summary>
+	/// Delayed jobs never start before their delay has passed, all start, and they start in the order
+	/// they expire in. A cancelled timer's job never runs.
+	/// </summary>
+	static void TimerExpiry(CheckContext& context)
+	{
+		std::unique_ptr<JobSystemManager> manager = StartManager(1);
+		if (!JS_EXPECT(context, manager != nullptr, "Could not start a job system with one worker."))
+		{
+			return;
+		}
+
+		// Delays 2ms apart, more than the wheel's 1ms tick, so no two expire on the same tick.
+		uint32_t const timerJobs = 32;
+		std::vector<uint32_t> delayOrder(timerJobs);
+		std::iota(delayOrder.begin(), delayOrder.end(), 0);
+		std::shuffle(delayOrder.begin(), delayOrder.end(), std::mt19937(39));
+
+		std::vector<Clock::time_point> dueTimes(timerJobs);
+		std::vector<Clock::time_point> startTimes(timerJobs);
+		std::vector<uint32_t> order(timerJobs);
+		std::atomic<uint32_t> started = 0;
+		for (uint32_t rank : delayOrder)
+		{
+			std::chrono::milliseconds const delay(2 * (rank + 1));
+			auto job = JobSystemManager::CreateJob(JobPriority::Normal, [&startTimes, &order, &started, rank]()
+												   {
+													   startTimes[rank] = Clock::now();
+													   order[started.load(std::memory_order_relaxed)] = rank;
+													   started.fetch_add(1, std::memory_order_release);
+												   });
+			// Taken before scheduling, so it is never later than the time the job is really due.
+			dueTimes[rank] = Clock::now() + delay;
+			manager->ScheduleJobAfter(job, delay);
+		}
+
+		bool canceledRan = false;
+		auto canceled = JobSystemManager::CreateJob(JobPriority::Normal, [&canceledRan]() { canceledRan = true; });
+		TimerHandle const handle = manager->ScheduleJobAfter(canceled, std::chrono::milliseconds(20));
+		JS_EXPECT(context, manager->CancelTimer(handle), "A pending timer could not be cancelled.");
+
+		if (JS_EXPECT(context, WaitFor(started, timerJobs), "Not every delayed job ran."))
+		{
+			for (uint32_t rank = 0; rank < timerJobs; ++rank)
+			{
+				JS_EXPECT(context, startTimes[rank] >= dueTimes[rank], "Delayed job " + std::to_string(rank) + " started "
+						  + std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(dueTimes[rank] - startTimes[rank]).count()) + "us early.");
+			}
+			JS_EXPECT(context, std::is_sorted(order.begin(), order.end()), "Delayed jobs did not start in the order they expired in.");
+		}
+		JS_EXPECT(context, !canceledRan && canceled->GetState() == JobState::Canceled, "A cancelled timer's job ran or was not marked cancelled.");
+		manager->Shutdown(true);
+	}
+	JS_CHECK(TimerExpiry);
+
+	/// <summary>
+	/// A recurring job can't be made recurring again until it is cancelled and done, then it can.
+	/// </summary>
+	static void RecurringReschedule(CheckContext& context)
+	{
+		std::unique_ptr<JobSystemManager> manager = StartManager(1);
+		if (!JS_EXPECT(context, manager != nullptr, "Could not start a job system with one worker."))
+		{
+			return;
+		}
+
+		std::atomic<uint32_t> runs = 0;
+		auto job = JobSystemManager::CreateJob(JobPriority::Normal, [&runs]() { runs.fetch_add(1, std::memory_order_release); });
+		manager->ScheduleJobEvery(job, std::chrono::milliseconds(1));
+		bool threw = false;
+		try
+		{
+			manager->ScheduleJobEvery(job, std::chrono::milliseconds(2));
+		}
+		catch (std::logic_error const&)
+		{
+			threw = true;
+		}
+		JS_EXPECT(context, threw, "Scheduling a recurring job again did not throw.");
+		JS_EXPECT(context, WaitFor(runs, 2), "The recurring job did not run.");
+		JS_EXPECT(context, manager->CancelRecurring(job), "A recurring job could not be cancelled.");
+		job->Wait();
+
+		uint32_t const runsBefore = runs.load(std::memory_order_acquire);
+		manager->ScheduleJobEvery(job, std::chrono::milliseconds(1));
+		JS_EXPECT(context, WaitFor(runs, runsBefore + 2), "A cancelled recurring job did not run again once rescheduled.");
+		JS_EXPECT(context, manager->CancelRecurring(job), "A rescheduled recurring job could not be cancelled.");
+		job->Wait();
+		manager->Shutdown(true);
+	}
+	JS_CHECK(RecurringReschedule);
+}
@@ -0,0 +1,135 @@
+#include "Check.h"
+#include "TaskGroup.h"
+#include <stdexcept>
+
+// Guarantees of TaskGroup exceptions, cancelling and joining. The group's jobs are queued behind a
+// WorkerGate, so the one worker runs them in the order they were run into the group.
+
+namespace Insight::JS::Check
+{
+	/// <summary>
+	/// The first exception cancels the jobs which have not started and 'Wait' rethrows it, after
+	/// 'Wait' the group runs jobs again.
+	/// </summary>
+	static void TaskGroupException(CheckContext& context)
+	{
+		std::unique_ptr<JobSystemManager> manager = StartManager(1);
+		if (!JS_EXPECT(context, manager != nullptr, "Could not start a job system with one worker."))
+		{
+			return;
+		}
+
+		uint32_t const jobs = 100;
+		uint32_t const throwingJob = 3;
+		std::atomic<uint32_t> ran = 0;
+		TaskGroup group(manager->GetMainJobSystem());
+		{
+			WorkerGate gate(*manager);
+			JS_EXPECT(context, gate.IsHeld(), "The worker never started the gate job.");
+			for (uint32_t i = 0; i < jobs; ++i)
+			{
+				group.Run([&ran, i, throwingJob]()
+						  {
+							  ran.fetch_add(1, std::memory_order_relaxed);
+							  if (i >= throwingJob)
+							  {
+								  throw std::runtime_error(i == throwingJob ? "First" : "Later");
+							  }
+						  });
+			}
+		}
+
+		std::string message;
+		try
+		{
+			group.Wait();
+		}
+		catch (std::runtime_error const& exception)
+		{
+			message = exception.what();
+		}
+		JS_EXPECT(context, message == "First", "Wait rethrew '" + message + "' instead of the first exception.");
+		JS_EXPECT(context, ran.load() == throwingJob + 1, std::to_string(ran.load()) + " jobs ran, the ones after the exception should have been cancelled.");
+		JS_EXPECT(context, group.GetPendingJobsCount() == 0, "Jobs were still pending after Wait.");
+
+		std::atomic<uint32_t> ranAgain = 0;
+		for (uint32_t i = 0; i < jobs; ++i)
+		{
+			group.Run([&ranAgain]() { ranAgain.fetch_add(1, std::memory_order_relaxed); });
+		}
+		group.Wait();
+		JS_EXPECT(context, ranAgain.load() == jobs, "The group did not run every job after Wait reset it.");
+		manager->Shutdown(true);
+	}
+	JS_CHECK(TaskGroupException);
+
+	/// <summary>
+	/// 'Cancel' skips the jobs which have not started, 'Wait' joins without throwing and resets the group.
+	/// </summary>
+	static void TaskGroupCancel(CheckContext& context)
+	{
+		std::unique_ptr<JobSystemManager> manager = StartManager(1);
+		if (!JS_EXPECT(context, manager != nullptr, "Could not start a job system with one worker."))
+		{
+			return;
+		}
+
+		uint32_t const jobs = 100;
+		std::atomic<uint32_t> ran = 0;
+		TaskGroup group(manager->GetMainJobSystem());
+		{
+			WorkerGate gate(*manager);
+			JS_EXPECT(context, gate.IsHeld(), "The worker never started the gate job.");
+			for (uint32_t i = 0; i < jobs; ++i)
+			{
+				group.Run([&ran]() { ran.fetch_add(1, std::memory_order_relaxed); });
+			}
+			group.Cancel();
+		}
+		group.Wait();
+		JS_EXPECT(context, ran.load() == 0, std::to_string(ran.load()) + " jobs of a cancelled group ran.");
+		JS_EXPECT(context, !group.IsCanceled() && group.GetPendingJobsCount() == 0, "Wait did not reset the cancelled group.");
+
+		group.Run([&ran]() { ran.fetch_add(1, std::memory_order_relaxed); });
+		group.Wait();
+		JS_EXPECT(context, ran.load() == 1, "The group did not run a job after a cancelled Wait.");
+		manager->Shutdown(true);
+	}
+	JS_CHECK(TaskGroupCancel);
+
+	/// <summary>
+	/// A job joining a group of its own on the only worker runs the group's jobs itself instead of deadlocking.
+	/// </summary>
+	static void TaskGroupNestedWait(CheckContext& context)
+	{
+		std::unique_ptr<JobSystemManager> manager = StartManager(1);
+		if (!JS_EXPECT(context, manager != nullptr, "Could not start a job system with one worker."))
+		{
+			return;
+		}
+
+		uint32_t const jobs = 16;
+		std::atomic<uint32_t> finished = 0;
+		std::atomic<uint32_t> ran = 0;
+		JobSystem& jobSystem = manager->GetMainJobSystem();
+		manager->ScheduleJob(JobSystemManager::CreateJob(JobPriority::Normal, [&jobSystem, &finished, &ran, jobs]()
+														 {
+															 TaskGroup group(jobSystem);
+															 for (uint32_t i = 0; i < jobs; ++i)
+															 {
+																 group.Run([&ran]() { ran.fetch_add(1, std::memory_order_relaxed); });
+															 }
+															 group.Wait();
+															 finished.fetch_add(1, std::memory_order_release);
+														 }));
+		if (!JS_EXPECT(context, WaitFor(finished, 1, std::chrono::seconds(10)), "TaskGroup::Wait on the only worker deadlocked."))
+		{
+			// The worker never returns, leave the manager running rather than joining it.
+			manager.release();
+			return;
+		}
+		JS_EXPECT(context, ran.load() == jobs, "Not every job of the nested group ran before Wait returned.");
+		manager->Shutdown(true);
+	}
+	JS_CHECK(TaskGroupNestedWait);
+}
@@ -14,6 +14,29 @@ workspace "JobSystem"
 		"MultiProcessorCompile"
     }
 
+newoption
+{
+    trigger = "with-openmp",
+    description = "Build the OpenMP comparative benchmarks in JobSystemBenchmark"
+}
+
+newoption
+{
+    trigger = "with-tbb",
+    description = "Build the TBB comparative benchmarks in JobSystemBenchmark (TBB must be installed)"
+}
+
+newoption
+{
+    trigger = "with-perf-counters",
+    description = "Read Linux perf_event hardware counters around every job (JS_ENABLE_PERF_COUNTERS)"
+}
+
+-- Set for every project, it changes the layout of Thread in the JobSystem headers.
+filter "options:with-perf-counters"
+    defines { "JS_ENABLE_PERF_COUNTERS" }
+filter {}
+
 outputdir = "%{cfg.buildcfg}-%{cfg.system}-%{cfg.architecture}"
 
 -- Include directories relative to root folder (solution directory)
@@ -21,4 +44,6 @@ IncludeDir = {}
 IncludeDir["JobSystem"]         = "$(SolutionDir)JobSystem/inc/"
 
 include "JobSystem"
-include "JobSystemTest"
\ No newline at end of file
+include "JobSystemTest"
+include "JobSystemBenchmark"
+include "JobSystemChecks"
\ No newline at end of file